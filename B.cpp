@@ -1,12 +1,26 @@
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
 #include <cstdint>
-#include <iostream>
+#include <cstdio>
+#include <cstring>
+#include <future>
+#include <optional>
 #include <random>
+#include <stdexcept>
 #include <string>
 #include <utility>
 #include <vector>
 
 namespace math {
 
+using int128 = __int128;
+using uint128 = unsigned __int128;
+
 class Number {
  public:
   Number(uint64_t base, std::vector<uint64_t> digits) : base_(base),
@@ -22,9 +36,9 @@ class Number {
   Number& operator*=(uint64_t num) {
     uint64_t remainder = 0;
     for (size_t i = 0; i < digits_.size(); ++i) {
-      digits_[i] *= num;
-      digits_[i] += remainder;
-      remainder = Split(i);
+      uint128 product = static_cast<uint128>(digits_[i]) * num + remainder;
+      digits_[i] = static_cast<uint64_t>(product % base_);
+      remainder = static_cast<uint64_t>(product / base_);
     }
     digits_.push_back(remainder);
     Normalize();
@@ -43,6 +57,10 @@ class Number {
     return digits_[i];
   }
 
+  [[nodiscard]] std::vector<uint64_t> GetDigits() const {
+    return digits_;
+  }
+
  private:
   void Normalize() {
     for (size_t i = 0; i < digits_.size(); ++i) {
@@ -71,7 +89,345 @@ class Number {
   std::vector<uint64_t> digits_;
 };
 
-Number Rebase(const Number& num, uint64_t new_base) {
+class MontgomeryContext {
+ public:
+  // Modulus must be odd.
+  explicit MontgomeryContext(uint64_t mod) : mod_(mod), mod_inv_(mod) {
+    // Newton's iteration doubles the number of correct low bits each step.
+    for (int i = 0; i < 5; ++i) {
+      mod_inv_ *= 2 - mod_ * mod_inv_;
+    }
+    r2_ = static_cast<uint64_t>(-static_cast<uint128>(mod_) % mod_);
+  }
+
+  [[nodiscard]] uint64_t Mod() const {
+    return mod_;
+  }
+
+  // Expects x < mod.
+  [[nodiscard]] uint64_t ToMontgomery(uint64_t x) const {
+    return Reduce(static_cast<uint128>(x) * r2_);
+  }
+
+  [[nodiscard]] uint64_t FromMontgomery(uint64_t x) const {
+    return Reduce(x);
+  }
+
+  // Returns a * b * 2^-64. If exactly one of the arguments is in Montgomery
+  // form, the result is the ordinary product.
+  [[nodiscard]] uint64_t Mul(uint64_t a, uint64_t b) const {
+    return Reduce(static_cast<uint128>(a) * b);
+  }
+
+  // Both x and the result are in Montgomery form.
+  [[nodiscard]] uint64_t Pow(uint64_t x, uint64_t y) const {
+    uint64_t result = ToMontgomery(1);
+    while (y > 0) {
+      if ((y & 1) == 1) {
+        result = Mul(result, x);
+      }
+      x = Mul(x, x);
+      y >>= 1;
+    }
+    return result;
+  }
+
+ private:
+  [[nodiscard]] uint64_t Reduce(uint128 t) const {
+    uint64_t m = static_cast<uint64_t>(t) * mod_inv_;
+    uint64_t t_high = static_cast<uint64_t>(t >> 64);
+    uint64_t m_mod_high = static_cast<uint64_t>(
+            (static_cast<uint128>(m) * mod_) >> 64);
+    if (t_high >= m_mod_high) {
+      return t_high - m_mod_high;
+    }
+    return t_high - m_mod_high + mod_;
+  }
+
+  uint64_t mod_;
+  uint64_t mod_inv_;
+  uint64_t r2_;
+};
+
+const int64_t kLimbMask62 = (int64_t{1} << 62) - 1;
+
+// Transition matrix of 62 divsteps: it maps (f, g) to
+// ((u f + v g) / 2^62, (q f + r g) / 2^62).
+struct DivstepMatrix {
+  int64_t u;
+  int64_t v;
+  int64_t q;
+  int64_t r;
+};
+
+// Runs 62 divsteps on the low bits of f and g, skipping runs of zero bits of
+// g at once. eta is minus the delta of the Bernstein-Yang paper.
+int64_t Divsteps62(int64_t eta, uint64_t f, uint64_t g,
+                   DivstepMatrix& matrix) {
+  uint64_t u = 1;
+  uint64_t v = 0;
+  uint64_t q = 0;
+  uint64_t r = 1;
+  int i = 62;
+  while (true) {
+    int zeros = __builtin_ctzll(g | (UINT64_MAX << i));
+    g >>= zeros;
+    u <<= zeros;
+    v <<= zeros;
+    eta -= zeros;
+    i -= zeros;
+    if (i == 0) {
+      break;
+    }
+    uint64_t w;
+    if (eta < 0) {
+      eta = -eta;
+      uint64_t tmp = f;
+      f = g;
+      g = -tmp;
+      tmp = u;
+      u = q;
+      q = -tmp;
+      tmp = v;
+      v = r;
+      r = -tmp;
+      int limit = std::min(static_cast<int>(eta) + 1, i);
+      uint64_t mask = (UINT64_MAX >> (64 - limit)) & 63;
+      w = (f * g * (f * f - 2)) & mask;
+    } else {
+      int limit = std::min(static_cast<int>(eta) + 1, i);
+      uint64_t mask = (UINT64_MAX >> (64 - limit)) & 15;
+      w = f + (((f + 1) & 4) << 1);
+      w = (-w * g) & mask;
+    }
+    g += f * w;
+    q += u * w;
+    r += v * w;
+  }
+  matrix = {static_cast<int64_t>(u), static_cast<int64_t>(v),
+            static_cast<int64_t>(q), static_cast<int64_t>(r)};
+  return eta;
+}
+
+// Modular inversion by Bernstein-Yang divsteps (safegcd) over W-word numbers.
+// Values are kept in L signed 62-bit limbs: every limb but the top one is in
+// [0, 2^62), the top one carries the sign.
+template<size_t W>
+class SafeGcd {
+ public:
+  static constexpr size_t kLimbs = 64 * W / 62 + 1;
+  using Limbs = std::array<int64_t, kLimbs>;
+
+  // Writes a^-1 modulo an odd mod into result, or 0 for a = 0. Expects
+  // gcd(a, mod) = 1.
+  static void Inverse(const uint64_t* a, const uint64_t* mod,
+                      uint64_t* result) {
+    Limbs modulus = ToLimbs(mod);
+    uint64_t mod_inv = mod[0];
+    for (size_t i = 0; i < 5; ++i) {
+      mod_inv *= 2 - mod[0] * mod_inv;
+    }
+    mod_inv &= kLimbMask62;
+
+    // Invariants: d * a = f and e * a = g modulo mod.
+    Limbs d{};
+    Limbs e{};
+    e[0] = 1;
+    Limbs f = modulus;
+    Limbs g = ToLimbs(a);
+    size_t len = kLimbs;
+    int64_t eta = -1;
+    while (true) {
+      DivstepMatrix matrix{};
+      eta = Divsteps62(eta, f[0], g[0], matrix);
+      UpdateDe(d, e, matrix, modulus, mod_inv);
+      UpdateFg(len, f, g, matrix);
+      if (g[0] == 0) {
+        int64_t rest = 0;
+        for (size_t i = 1; i < len; ++i) {
+          rest |= g[i];
+        }
+        if (rest == 0) {
+          break;
+        }
+      }
+      // Drop the top limb once both f and g fit into one limb less.
+      int64_t f_top = f[len - 1];
+      int64_t g_top = g[len - 1];
+      if (len > 1 && (f_top ^ (f_top >> 63)) == 0 &&
+          (g_top ^ (g_top >> 63)) == 0) {
+        f[len - 2] |= static_cast<int64_t>(static_cast<uint64_t>(f_top) << 62);
+        g[len - 2] |= static_cast<int64_t>(static_cast<uint64_t>(g_top) << 62);
+        --len;
+      }
+    }
+
+    // Now f = +-1, so the inverse is +-d, which lies in (-2 mod, mod).
+    if (f[len - 1] < 0) {
+      for (int64_t& limb : d) {
+        limb = -limb;
+      }
+      Carry(d);
+    }
+    while (d[kLimbs - 1] < 0) {
+      for (size_t i = 0; i < kLimbs; ++i) {
+        d[i] += modulus[i];
+      }
+      Carry(d);
+    }
+    while (!Less(d, modulus)) {
+      for (size_t i = 0; i < kLimbs; ++i) {
+        d[i] -= modulus[i];
+      }
+      Carry(d);
+    }
+    FromLimbs(d, result);
+  }
+
+ private:
+  static Limbs ToLimbs(const uint64_t* words) {
+    Limbs limbs{};
+    for (size_t i = 0; i < kLimbs; ++i) {
+      size_t word = 62 * i / 64;
+      size_t shift = 62 * i % 64;
+      uint64_t value = 0;
+      if (word < W) {
+        value = words[word] >> shift;
+        if (shift > 2 && word + 1 < W) {
+          value |= words[word + 1] << (64 - shift);
+        }
+      }
+      limbs[i] = static_cast<int64_t>(value) & kLimbMask62;
+    }
+    return limbs;
+  }
+
+  // Expects a carried value in [0, 2^(64 W)).
+  static void FromLimbs(const Limbs& limbs, uint64_t* words) {
+    std::fill(words, words + W, 0);
+    for (size_t i = 0; i < kLimbs; ++i) {
+      size_t word = 62 * i / 64;
+      size_t shift = 62 * i % 64;
+      auto limb = static_cast<uint64_t>(limbs[i]);
+      if (word < W) {
+        words[word] |= limb << shift;
+        if (shift > 2 && word + 1 < W) {
+          words[word + 1] |= limb >> (64 - shift);
+        }
+      }
+    }
+  }
+
+  static void Carry(Limbs& limbs) {
+    for (size_t i = 0; i + 1 < kLimbs; ++i) {
+      limbs[i + 1] += limbs[i] >> 62;
+      limbs[i] &= kLimbMask62;
+    }
+  }
+
+  static bool Less(const Limbs& x, const Limbs& y) {
+    for (size_t i = kLimbs; i > 0; --i) {
+      if (x[i - 1] != y[i - 1]) {
+        return x[i - 1] < y[i - 1];
+      }
+    }
+    return false;
+  }
+
+  // Applies the matrix to (d, e) and divides by 2^62 modulo mod, adding the
+  // multiple of mod that clears the low 62 bits. Keeps both in (-2 mod, mod).
+  static void UpdateDe(Limbs& d, Limbs& e, const DivstepMatrix& matrix,
+                       const Limbs& modulus, uint64_t mod_inv) {
+    int64_t d_sign = d[kLimbs - 1] >> 63;
+    int64_t e_sign = e[kLimbs - 1] >> 63;
+    int64_t md = (matrix.u & d_sign) + (matrix.v & e_sign);
+    int64_t me = (matrix.q & d_sign) + (matrix.r & e_sign);
+    int128 cd = static_cast<int128>(matrix.u) * d[0] +
+                static_cast<int128>(matrix.v) * e[0];
+    int128 ce = static_cast<int128>(matrix.q) * d[0] +
+                static_cast<int128>(matrix.r) * e[0];
+    md -= static_cast<int64_t>((mod_inv * static_cast<uint64_t>(cd) +
+                                static_cast<uint64_t>(md)) & kLimbMask62);
+    me -= static_cast<int64_t>((mod_inv * static_cast<uint64_t>(ce) +
+                                static_cast<uint64_t>(me)) & kLimbMask62);
+    cd += static_cast<int128>(modulus[0]) * md;
+    ce += static_cast<int128>(modulus[0]) * me;
+    cd >>= 62;
+    ce >>= 62;
+    for (size_t i = 1; i < kLimbs; ++i) {
+      cd += static_cast<int128>(matrix.u) * d[i] +
+            static_cast<int128>(matrix.v) * e[i] +
+            static_cast<int128>(modulus[i]) * md;
+      ce += static_cast<int128>(matrix.q) * d[i] +
+            static_cast<int128>(matrix.r) * e[i] +
+            static_cast<int128>(modulus[i]) * me;
+      d[i - 1] = static_cast<int64_t>(cd) & kLimbMask62;
+      e[i - 1] = static_cast<int64_t>(ce) & kLimbMask62;
+      cd >>= 62;
+      ce >>= 62;
+    }
+    d[kLimbs - 1] = static_cast<int64_t>(cd);
+    e[kLimbs - 1] = static_cast<int64_t>(ce);
+  }
+
+  // Applies the matrix to the first len limbs of (f, g); the low 62 bits of
+  // the products are zero and get shifted out.
+  static void UpdateFg(size_t len, Limbs& f, Limbs& g,
+                       const DivstepMatrix& matrix) {
+    int128 cf = static_cast<int128>(matrix.u) * f[0] +
+                static_cast<int128>(matrix.v) * g[0];
+    int128 cg = static_cast<int128>(matrix.q) * f[0] +
+                static_cast<int128>(matrix.r) * g[0];
+    cf >>= 62;
+    cg >>= 62;
+    for (size_t i = 1; i < len; ++i) {
+      cf += static_cast<int128>(matrix.u) * f[i] +
+            static_cast<int128>(matrix.v) * g[i];
+      cg += static_cast<int128>(matrix.q) * f[i] +
+            static_cast<int128>(matrix.r) * g[i];
+      f[i - 1] = static_cast<int64_t>(cf) & kLimbMask62;
+      g[i - 1] = static_cast<int64_t>(cg) & kLimbMask62;
+      cf >>= 62;
+      cg >>= 62;
+    }
+    f[len - 1] = static_cast<int64_t>(cf);
+    g[len - 1] = static_cast<int64_t>(cg);
+  }
+};
+
+uint64_t InverseMod(uint64_t a, uint64_t mod) {
+  uint64_t result = 0;
+  SafeGcd<1>::Inverse(&a, &mod, &result);
+  return result;
+}
+
+// Replaces every value in Montgomery form by its inverse using Montgomery's
+// trick: one inversion and three multiplications per element. Zeros are left
+// as they are.
+void InvertBatch(const MontgomeryContext& context,
+                 std::vector<uint64_t>& values) {
+  uint64_t one = context.ToMontgomery(1);
+  std::vector<uint64_t> prefix(values.size() + 1);
+  prefix[0] = one;
+  for (size_t i = 0; i < values.size(); ++i) {
+    prefix[i + 1] = values[i] == 0 ? prefix[i]
+                                   : context.Mul(prefix[i], values[i]);
+  }
+  uint64_t inv = context.ToMontgomery(InverseMod(
+          context.FromMontgomery(prefix.back()), context.Mod()));
+  for (size_t i = values.size(); i > 0; --i) {
+    if (values[i - 1] == 0) {
+      continue;
+    }
+    uint64_t value = values[i - 1];
+    values[i - 1] = context.Mul(inv, prefix[i - 1]);
+    inv = context.Mul(inv, value);
+  }
+}
+
+// Schoolbook conversion, used for short numbers and as the recursion leaf of
+// Rebase.
+Number RebaseQuadratic(const Number& num, uint64_t new_base) {
   Number new_number(new_base, {0});
   for (size_t i = num.Size(); i > 0; --i) {
     new_number *= num.Base();
@@ -80,20 +436,273 @@ Number Rebase(const Number& num, uint64_t new_base) {
   return new_number;
 }
 
-uint64_t BinPow(uint64_t x, uint64_t y, uint64_t mod) {
-  if (y == 0) {
-    return 1;
+struct NttPrime {
+  uint64_t mod;
+  uint64_t root;
+};
+
+// Primes of the form c * 2^k + 1 with k >= 54 and their primitive roots. The
+// product of the three exceeds 2^183, which is enough to restore convolutions
+// of digits below 2^63 exactly.
+constexpr NttPrime kNttPrimes[] = {{4179340454199820289, 3},
+                                   {2485986994308513793, 5},
+                                   {2936346957045563393, 3}};
+
+// In-place transform of a vector in Montgomery form, size is a power of two.
+void Ntt(std::vector<uint64_t>& a, const MontgomeryContext& context,
+         uint64_t root, bool invert) {
+  size_t n = a.size();
+  for (size_t i = 1, j = 0; i < n; ++i) {
+    size_t bit = n >> 1;
+    for (; (j & bit) != 0; bit >>= 1) {
+      j ^= bit;
+    }
+    j ^= bit;
+    if (i < j) {
+      std::swap(a[i], a[j]);
+    }
+  }
+  uint64_t mod = context.Mod();
+  uint64_t root_mont = context.ToMontgomery(root);
+  std::vector<uint64_t> twiddles(n / 2);
+  for (size_t len = 2; len <= n; len <<= 1) {
+    uint64_t exponent = (mod - 1) / len;
+    uint64_t w_len = context.Pow(root_mont,
+                                 invert ? mod - 1 - exponent : exponent);
+    size_t half = len / 2;
+    twiddles[0] = context.ToMontgomery(1);
+    for (size_t j = 1; j < half; ++j) {
+      twiddles[j] = context.Mul(twiddles[j - 1], w_len);
+    }
+    for (size_t i = 0; i < n; i += len) {
+      for (size_t j = 0; j < half; ++j) {
+        uint64_t u = a[i + j];
+        uint64_t v = context.Mul(a[i + j + half], twiddles[j]);
+        a[i + j] = u + v >= mod ? u + v - mod : u + v;
+        a[i + j + half] = u >= v ? u - v : u + mod - v;
+      }
+    }
+  }
+}
+
+std::vector<uint64_t> ConvolveModPrime(const std::vector<uint64_t>& a,
+                                       const std::vector<uint64_t>& b,
+                                       const NttPrime& prime, size_t size) {
+  MontgomeryContext context(prime.mod);
+  std::vector<uint64_t> fa(size), fb(size);
+  for (size_t i = 0; i < a.size(); ++i) {
+    fa[i] = context.ToMontgomery(a[i] % prime.mod);
+  }
+  for (size_t i = 0; i < b.size(); ++i) {
+    fb[i] = context.ToMontgomery(b[i] % prime.mod);
+  }
+  Ntt(fa, context, prime.root, /*invert=*/false);
+  Ntt(fb, context, prime.root, /*invert=*/false);
+  for (size_t i = 0; i < size; ++i) {
+    fa[i] = context.Mul(fa[i], fb[i]);
+  }
+  Ntt(fa, context, prime.root, /*invert=*/true);
+  uint64_t size_inv = context.FromMontgomery(
+          context.Pow(context.ToMontgomery(size % prime.mod), prime.mod - 2));
+  for (size_t i = 0; i < size; ++i) {
+    fa[i] = context.Mul(fa[i], size_inv);
+  }
+  return fa;
+}
+
+void TrimDigits(std::vector<uint64_t>& digits) {
+  while (digits.size() > 1 && digits.back() == 0) {
+    digits.pop_back();
+  }
+}
+
+std::vector<uint64_t> AddDigits(const std::vector<uint64_t>& a,
+                                const std::vector<uint64_t>& b,
+                                uint64_t base) {
+  std::vector<uint64_t> result(std::max(a.size(), b.size()) + 1);
+  uint64_t carry = 0;
+  for (size_t i = 0; i + 1 < result.size(); ++i) {
+    uint64_t sum = carry;
+    sum += i < a.size() ? a[i] : 0;
+    sum += i < b.size() ? b[i] : 0;
+    carry = sum >= base ? 1 : 0;
+    result[i] = sum - carry * base;
+  }
+  result.back() = carry;
+  TrimDigits(result);
+  return result;
+}
+
+std::vector<uint64_t> MulDigits(const std::vector<uint64_t>& a,
+                                const std::vector<uint64_t>& b,
+                                uint64_t base) {
+  std::vector<uint64_t> result(a.size() + b.size());
+  if (std::min(a.size(), b.size()) <= 32) {
+    for (size_t i = 0; i < a.size(); ++i) {
+      uint64_t carry = 0;
+      for (size_t j = 0; j < b.size(); ++j) {
+        uint128 cur = static_cast<uint128>(a[i]) * b[j] + result[i + j] +
+                      carry;
+        result[i + j] = static_cast<uint64_t>(cur % base);
+        carry = static_cast<uint64_t>(cur / base);
+      }
+      result[i + b.size()] = carry;
+    }
+    TrimDigits(result);
+    return result;
+  }
+
+  size_t size = 1;
+  while (size < a.size() + b.size()) {
+    size <<= 1;
+  }
+  std::vector<uint64_t> residues[3];
+  for (int k = 0; k < 3; ++k) {
+    residues[k] = ConvolveModPrime(a, b, kNttPrimes[k], size);
+  }
+
+  // Restore every coefficient with Garner's algorithm as a 192-bit value
+  // x = a0 + a1 * m0 + a2 * m0 * m1 and propagate carries in the new base.
+  uint64_t m0 = kNttPrimes[0].mod;
+  uint64_t m1 = kNttPrimes[1].mod;
+  uint64_t m2 = kNttPrimes[2].mod;
+  MontgomeryContext context1(m1), context2(m2);
+  uint64_t m0_inv_mod_m1 = context1.Pow(context1.ToMontgomery(m0 % m1),
+                                        m1 - 2);
+  uint64_t m0_mod_m2 = context2.ToMontgomery(m0 % m2);
+  uint64_t m0_m1_inv_mod_m2 = context2.Pow(
+          context2.Mul(m0_mod_m2, context2.ToMontgomery(m1 % m2)), m2 - 2);
+  uint128 m0_m1 = static_cast<uint128>(m0) * m1;
+  uint128 carry = 0;
+  for (size_t i = 0; i + 1 < result.size(); ++i) {
+    uint64_t a0 = residues[0][i];
+    uint64_t a0_mod_m1 = a0 % m1;
+    uint64_t r1 = residues[1][i];
+    uint64_t a1 = context1.Mul(
+            r1 >= a0_mod_m1 ? r1 - a0_mod_m1 : r1 + m1 - a0_mod_m1,
+            m0_inv_mod_m1);
+    uint64_t known = a0 % m2 + context2.Mul(a1, m0_mod_m2);
+    known = known >= m2 ? known - m2 : known;
+    uint64_t r2 = residues[2][i];
+    uint64_t a2 = context2.Mul(r2 >= known ? r2 - known : r2 + m2 - known,
+                               m0_m1_inv_mod_m2);
+
+    uint128 low = static_cast<uint128>(a2) * static_cast<uint64_t>(m0_m1);
+    uint128 high = static_cast<uint128>(a2) *
+                   static_cast<uint64_t>(m0_m1 >> 64) + (low >> 64);
+    uint64_t limbs[3] = {static_cast<uint64_t>(low),
+                         static_cast<uint64_t>(high),
+                         static_cast<uint64_t>(high >> 64)};
+    for (uint128 term : {static_cast<uint128>(a1) * m0,
+                         static_cast<uint128>(a0), carry}) {
+      uint128 sum = static_cast<uint128>(limbs[0]) +
+                    static_cast<uint64_t>(term);
+      limbs[0] = static_cast<uint64_t>(sum);
+      sum = static_cast<uint128>(limbs[1]) + static_cast<uint64_t>(term >> 64) +
+            (sum >> 64);
+      limbs[1] = static_cast<uint64_t>(sum);
+      limbs[2] += static_cast<uint64_t>(sum >> 64);
+    }
+
+    // The quotient is below base * size, so it fits into 128 bits.
+    uint128 remainder = limbs[2] % base;
+    uint128 cur = (remainder << 64) | limbs[1];
+    uint64_t quotient_high = static_cast<uint64_t>(cur / base);
+    cur = ((cur % base) << 64) | limbs[0];
+    uint64_t quotient_low = static_cast<uint64_t>(cur / base);
+    result[i] = static_cast<uint64_t>(cur % base);
+    carry = (static_cast<uint128>(quotient_high) << 64) | quotient_low;
+  }
+  result.back() = static_cast<uint64_t>(carry);
+  TrimDigits(result);
+  return result;
+}
+
+constexpr size_t kRebaseLeafSize = 64;
+
+// Converts digits [begin, begin + kRebaseLeafSize * 2^level) of the source
+// number. powers[k] holds base^(kRebaseLeafSize * 2^k) in the new base.
+std::vector<uint64_t>
+RebaseRange(const std::vector<uint64_t>& digits, size_t begin, size_t level,
+            uint64_t base, uint64_t new_base,
+            const std::vector<std::vector<uint64_t>>& powers) {
+  size_t end = std::min(digits.size(), begin + (kRebaseLeafSize << level));
+  if (level == 0) {
+    Number leaf(base, std::vector<uint64_t>(digits.begin() + begin,
+                                            digits.begin() + end));
+    return RebaseQuadratic(leaf, new_base).GetDigits();
   }
-  if ((y & 1) == 0) {
-    uint64_t half = BinPow(x, y >> 1, mod);
-    return (half * half) % mod;
-  } else {
-    return (x * BinPow(x, y - 1, mod)) % mod;
+  size_t middle = begin + (kRebaseLeafSize << (level - 1));
+  if (middle >= end) {
+    return RebaseRange(digits, begin, level - 1, base, new_base, powers);
   }
+  std::vector<uint64_t> low = RebaseRange(digits, begin, level - 1, base,
+                                          new_base, powers);
+  std::vector<uint64_t> high = RebaseRange(digits, middle, level - 1, base,
+                                           new_base, powers);
+  return AddDigits(low, MulDigits(high, powers[level - 1], new_base),
+                   new_base);
 }
 
-uint64_t Mul(uint64_t a, uint64_t b, uint64_t mod) {
-  return (a * b) % mod;
+// Largest power base^width below 2^63. Small bases are packed into it, which
+// shortens the digit vectors Rebase works on.
+std::pair<uint64_t, size_t> PackedBase(uint64_t base) {
+  uint64_t packed_base = base;
+  size_t width = 1;
+  while (packed_base <= (uint64_t{1} << 63) / base) {
+    packed_base *= base;
+    ++width;
+  }
+  return {packed_base, width};
+}
+
+std::vector<uint64_t> PackDigits(const std::vector<uint64_t>& digits,
+                                 uint64_t base, size_t width) {
+  std::vector<uint64_t> packed((digits.size() + width - 1) / width);
+  for (size_t i = digits.size(); i > 0; --i) {
+    packed[(i - 1) / width] = packed[(i - 1) / width] * base + digits[i - 1];
+  }
+  return packed;
+}
+
+std::vector<uint64_t> UnpackDigits(const std::vector<uint64_t>& packed,
+                                   uint64_t base, size_t width) {
+  std::vector<uint64_t> digits;
+  digits.reserve(packed.size() * width);
+  for (uint64_t item : packed) {
+    for (size_t j = 0; j < width; ++j) {
+      digits.push_back(item % base);
+      item /= base;
+    }
+  }
+  TrimDigits(digits);
+  return digits;
+}
+
+// Divide-and-conquer radix conversion: both halves of the number are
+// converted recursively and joined by a multiplication by a precomputed power
+// of the old base. With NTT multiplication this takes O(n log^2 n).
+Number Rebase(const Number& num, uint64_t new_base) {
+  if (num.Size() <= kRebaseLeafSize) {
+    return RebaseQuadratic(num, new_base);
+  }
+  auto [base, width] = PackedBase(num.Base());
+  auto [packed_new_base, new_width] = PackedBase(new_base);
+  std::vector<uint64_t> digits = PackDigits(num.GetDigits(), num.Base(),
+                                            width);
+  std::vector<uint64_t> leaf_power(kRebaseLeafSize + 1);
+  leaf_power.back() = 1;
+  std::vector<std::vector<uint64_t>> powers = {
+          RebaseQuadratic(Number(base, leaf_power), packed_new_base)
+                  .GetDigits()};
+  while ((kRebaseLeafSize << powers.size()) < digits.size()) {
+    powers.push_back(MulDigits(powers.back(), powers.back(),
+                               packed_new_base));
+  }
+  std::vector<uint64_t> result = RebaseRange(digits, /*begin=*/0,
+                                             /*level=*/powers.size(), base,
+                                             packed_new_base, powers);
+  return {new_base, UnpackDigits(result, new_base, new_width)};
 }
 
 }  // namespace math
@@ -157,52 +766,519 @@ std::string DecodeString(const math::Number& number) {
 
 }  // namespace encoding
 
+namespace io {
+
+constexpr size_t kBufferSize = 1 << 16;
+
+// Buffered input on top of fread with hand-rolled integer parsing. It can
+// also parse a memory region in place, e.g. a mapped file.
+class Reader {
+ public:
+  explicit Reader(FILE* file)
+          : file_(file), buffer_(kBufferSize), data_(buffer_.data()) {}
+
+  Reader(const char* data, size_t size)
+          : file_(nullptr), data_(data), size_(size) {}
+
+  Reader(const Reader&) = delete;
+  Reader& operator=(const Reader&) = delete;
+
+  // Returns the next character without extracting it, or EOF.
+  int Peek() {
+    if (pos_ == size_ && !Refill()) {
+      return EOF;
+    }
+    return static_cast<unsigned char>(data_[pos_]);
+  }
+
+  int Get() {
+    int c = Peek();
+    if (c != EOF) {
+      ++pos_;
+    }
+    return c;
+  }
+
+  void SkipSpaces() {
+    for (int c = Peek(); c == ' ' || c == '\n' || c == '\r' || c == '\t';
+         c = Peek()) {
+      ++pos_;
+    }
+  }
+
+  // Reads an unsigned decimal number, returns false if there is none.
+  bool Read(uint64_t& x) {
+    SkipSpaces();
+    int c = Peek();
+    if (c < '0' || c > '9') {
+      return false;
+    }
+    x = 0;
+    for (; c >= '0' && c <= '9'; c = Peek()) {
+      x = x * 10 + (c - '0');
+      ++pos_;
+    }
+    return true;
+  }
+
+  // Reads a whitespace-separated token, returns false at the end of input.
+  bool ReadToken(std::string& token) {
+    SkipSpaces();
+    token.clear();
+    for (int c = Peek(); c != EOF && c != ' ' && c != '\n' && c != '\r' &&
+                         c != '\t'; c = Peek()) {
+      token.push_back(static_cast<char>(c));
+      ++pos_;
+    }
+    return !token.empty();
+  }
+
+  // Reads the rest of the current line and extracts the line break. Returns
+  // false at the end of input.
+  bool ReadLine(std::string& line) {
+    line.clear();
+    if (Peek() == EOF) {
+      return false;
+    }
+    while (pos_ < size_ || Refill()) {
+      const char* begin = data_ + pos_;
+      const char* end = static_cast<const char*>(
+              std::memchr(begin, '\n', size_ - pos_));
+      if (end != nullptr) {
+        line.append(begin, end);
+        pos_ += end - begin + 1;
+        return true;
+      }
+      line.append(begin, size_ - pos_);
+      pos_ = size_;
+    }
+    return true;
+  }
+
+  // Reads up to n next characters of the current line, leaving the line
+  // break in place. Returns false when the line is exhausted.
+  bool ReadLineChunk(std::string& chunk, size_t n) {
+    chunk.clear();
+    while (chunk.size() < n && (pos_ < size_ || Refill())) {
+      const char* begin = data_ + pos_;
+      size_t available = std::min(size_ - pos_, n - chunk.size());
+      const char* end = static_cast<const char*>(
+              std::memchr(begin, '\n', available));
+      if (end != nullptr) {
+        chunk.append(begin, end);
+        pos_ += end - begin;
+        break;
+      }
+      chunk.append(begin, available);
+      pos_ += available;
+    }
+    return !chunk.empty();
+  }
+
+  // Reads n raw bytes, returns false if the input ends earlier.
+  bool ReadBytes(void* data, size_t n) {
+    auto* out = static_cast<char*>(data);
+    while (n > 0 && (pos_ < size_ || Refill())) {
+      size_t available = std::min(size_ - pos_, n);
+      std::memcpy(out, data_ + pos_, available);
+      pos_ += available;
+      out += available;
+      n -= available;
+    }
+    return n == 0;
+  }
+
+  // Reads a little-endian integer of the given width in bytes.
+  bool ReadLe(uint64_t& x, size_t bytes = sizeof(uint64_t)) {
+    uint8_t buffer[sizeof(uint64_t)];
+    if (!ReadBytes(buffer, bytes)) {
+      return false;
+    }
+    x = 0;
+    for (size_t i = bytes; i > 0; --i) {
+      x = (x << 8) | buffer[i - 1];
+    }
+    return true;
+  }
+
+ private:
+  bool Refill() {
+    if (file_ == nullptr) {
+      return false;
+    }
+    pos_ = 0;
+    size_ = std::fread(buffer_.data(), 1, buffer_.size(), file_);
+    return size_ > 0;
+  }
+
+  FILE* file_;
+  std::vector<char> buffer_;
+  const char* data_;
+  size_t pos_ = 0;
+  size_t size_ = 0;
+};
+
+// Read-only memory mapping of a whole file.
+class MappedFile {
+ public:
+  explicit MappedFile(const std::string& path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+      throw std::runtime_error("Cannot open " + path);
+    }
+    struct stat file_stat {};
+    if (fstat(fd, &file_stat) == 0) {
+      size_ = static_cast<size_t>(file_stat.st_size);
+    }
+    if (size_ > 0) {
+      void* data = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (data == MAP_FAILED) {
+        close(fd);
+        throw std::runtime_error("Cannot map " + path);
+      }
+      madvise(data, size_, MADV_SEQUENTIAL);
+      data_ = static_cast<const char*>(data);
+    }
+    close(fd);
+  }
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  ~MappedFile() {
+    if (data_ != nullptr) {
+      munmap(const_cast<char*>(data_), size_);
+    }
+  }
+
+  [[nodiscard]] const char* Data() const {
+    return data_;
+  }
+
+  [[nodiscard]] size_t Size() const {
+    return size_;
+  }
+
+ private:
+  const char* data_ = nullptr;
+  size_t size_ = 0;
+};
+
+// Buffered output on top of fwrite, flushed on destruction.
+class Writer {
+ public:
+  explicit Writer(FILE* file) : file_(file), buffer_(kBufferSize) {}
+
+  Writer(const Writer&) = delete;
+  Writer& operator=(const Writer&) = delete;
+
+  ~Writer() {
+    Flush();
+  }
+
+  void Write(char c) {
+    if (pos_ == buffer_.size()) {
+      Flush();
+    }
+    buffer_[pos_++] = c;
+  }
+
+  void Write(uint64_t x) {
+    char digits[20];
+    size_t n = 0;
+    do {
+      digits[n++] = static_cast<char>('0' + x % 10);
+      x /= 10;
+    } while (x > 0);
+    if (buffer_.size() - pos_ < n) {
+      Flush();
+    }
+    while (n > 0) {
+      buffer_[pos_++] = digits[--n];
+    }
+  }
+
+  void Write(const std::string& s) {
+    WriteBytes(s.data(), s.size());
+  }
+
+  void WriteBytes(const void* data, size_t n) {
+    const auto* in = static_cast<const char*>(data);
+    for (size_t written = 0; written < n;) {
+      if (pos_ == buffer_.size()) {
+        Flush();
+      }
+      size_t count = std::min(n - written, buffer_.size() - pos_);
+      std::memcpy(buffer_.data() + pos_, in + written, count);
+      pos_ += count;
+      written += count;
+    }
+  }
+
+  // Writes the lowest bytes of x in little-endian order.
+  void WriteLe(uint64_t x, size_t bytes = sizeof(uint64_t)) {
+    uint8_t buffer[sizeof(uint64_t)];
+    for (size_t i = 0; i < bytes; ++i) {
+      buffer[i] = static_cast<uint8_t>(x >> (8 * i));
+    }
+    WriteBytes(buffer, bytes);
+  }
+
+  void Flush() {
+    std::fwrite(buffer_.data(), 1, pos_, file_);
+    pos_ = 0;
+  }
+
+ private:
+  FILE* file_;
+  std::vector<char> buffer_;
+  size_t pos_ = 0;
+};
+
+// Binary ciphertext format, version 1. All integers are little-endian:
+//   "EGCT", u32 version, u32 value width in bytes, u32 values per element
+//   (the field degree), u64 modulus, u64 number of pairs,
+// followed by the pairs, each element stored as exactly that many values of
+// the smallest width that fits the modulus. E writes version 2, which stores
+// a 256-bit modulus.
+constexpr char kBinaryMagic[4] = {'E', 'G', 'C', 'T'};
+constexpr uint64_t kBinaryVersion = 1;
+
+struct BinaryHeader {
+  uint64_t width;
+  uint64_t degree;
+  uint64_t modulus;
+  uint64_t count;
+};
+
+// Number of bytes needed to store values below the modulus.
+uint64_t ValueWidth(uint64_t modulus) {
+  uint64_t width = 1;
+  while (width < sizeof(uint64_t) && (modulus - 1) >> (8 * width) != 0) {
+    ++width;
+  }
+  return width;
+}
+
+void WriteBinaryHeader(Writer& writer, const BinaryHeader& header) {
+  writer.WriteBytes(kBinaryMagic, sizeof(kBinaryMagic));
+  writer.WriteLe(kBinaryVersion, 4);
+  writer.WriteLe(header.width, 4);
+  writer.WriteLe(header.degree, 4);
+  writer.WriteLe(header.modulus);
+  writer.WriteLe(header.count);
+}
+
+// Returns false if the input is not a supported binary ciphertext.
+bool ReadBinaryHeader(Reader& reader, BinaryHeader& header) {
+  char magic[sizeof(kBinaryMagic)];
+  uint64_t version;
+  return reader.ReadBytes(magic, sizeof(magic)) &&
+         std::memcmp(magic, kBinaryMagic, sizeof(magic)) == 0 &&
+         reader.ReadLe(version, 4) && version == kBinaryVersion &&
+         reader.ReadLe(header.width, 4) && header.width > 0 &&
+         header.width <= sizeof(uint64_t) &&
+         reader.ReadLe(header.degree, 4) && reader.ReadLe(header.modulus) &&
+         reader.ReadLe(header.count);
+}
+
+}  // namespace io
+
 namespace crypto {
 
 std::pair<uint64_t, uint64_t>
-Encrypt(uint64_t message, uint64_t p, uint64_t g, uint64_t public_key,
-        std::mt19937 gen) {
+Encrypt(uint64_t message, const math::MontgomeryContext& context, uint64_t g,
+        uint64_t public_key, std::mt19937 gen) {
   // Generate random integer from [1, p - 1].
-  uint64_t b = 1 + gen() % (p - 1);
+  uint64_t b = 1 + gen() % (context.Mod() - 1);
   // ElGamal encryption.
-  uint64_t g_b = math::BinPow(g, b, /*mod=*/p);
-  uint64_t g_ab = math::BinPow(public_key, b, /*mod=*/p);
-  uint64_t encrypted = math::Mul(message, g_ab, /*mod=*/p);
+  uint64_t g_b = context.FromMontgomery(
+          context.Pow(context.ToMontgomery(g), b));
+  uint64_t g_ab = context.Pow(context.ToMontgomery(public_key), b);
+  uint64_t encrypted = context.Mul(message, g_ab);
   return {g_b, encrypted};
 }
 
-uint64_t Decrypt(std::pair<uint64_t, uint64_t> encrypted_message, uint64_t p,
-                 uint64_t private_key) {
-  uint64_t g_b = encrypted_message.first;
-  uint64_t actual_encrypted_message = encrypted_message.second;
-  uint64_t g_ab = math::BinPow(g_b, private_key, /*mod=*/p);
-  uint64_t g_ab_inv = math::BinPow(g_ab, p - 2, /*mod=*/p);
-  return math::Mul(actual_encrypted_message, g_ab_inv, /*mod=*/p);
+class Decryptor {
+ public:
+  // (g^b)^(p - 1 - a) = (g^ab)^-1, so a single exponentiation per element is
+  // enough.
+  Decryptor(const math::MontgomeryContext& context, uint64_t private_key)
+          : context_(context),
+            private_key_(private_key % (context.Mod() - 1)),
+            inverse_exponent_(context.Mod() - 1 - private_key_) {}
+
+  [[nodiscard]] uint64_t
+  Decrypt(std::pair<uint64_t, uint64_t> encrypted_message) const {
+    uint64_t g_b = context_.ToMontgomery(encrypted_message.first);
+    uint64_t actual_encrypted_message = encrypted_message.second;
+    uint64_t g_ab_inv = context_.Pow(g_b, inverse_exponent_);
+    return context_.Mul(actual_encrypted_message, g_ab_inv);
+  }
+
+  // Uses the folded exponent unless the private key is so short that
+  // computing g^ab and inverting all of them together is cheaper.
+  [[nodiscard]] std::vector<uint64_t> DecryptBatch(
+          const std::vector<std::pair<uint64_t, uint64_t>>& encrypted) const {
+    std::vector<uint64_t> decrypted(encrypted.size());
+    if (PowCost(inverse_exponent_) <= PowCost(private_key_) + 3) {
+      for (size_t i = 0; i < encrypted.size(); ++i) {
+        decrypted[i] = Decrypt(encrypted[i]);
+      }
+      return decrypted;
+    }
+    std::vector<uint64_t> g_ab(encrypted.size());
+    for (size_t i = 0; i < encrypted.size(); ++i) {
+      g_ab[i] = context_.Pow(context_.ToMontgomery(encrypted[i].first),
+                             private_key_);
+    }
+    math::InvertBatch(context_, g_ab);
+    for (size_t i = 0; i < encrypted.size(); ++i) {
+      decrypted[i] = context_.Mul(encrypted[i].second, g_ab[i]);
+    }
+    return decrypted;
+  }
+
+  [[nodiscard]] uint64_t Mod() const {
+    return context_.Mod();
+  }
+
+ private:
+  // Number of multiplications in binary exponentiation.
+  static int PowCost(uint64_t exponent) {
+    int cost = 0;
+    for (; exponent > 0; exponent >>= 1) {
+      cost += 1 + static_cast<int>(exponent & 1);
+    }
+    return cost;
+  }
+
+  math::MontgomeryContext context_;
+  uint64_t private_key_;
+  uint64_t inverse_exponent_;
+};
+
+std::string
+DecryptText(const std::vector<std::pair<uint64_t, uint64_t>>& encrypted,
+            const Decryptor& decryptor) {
+  math::Number message(decryptor.Mod(), decryptor.DecryptBatch(encrypted));
+  message = math::Rebase(message, 64);
+  return encoding::DecodeString(message);
 }
 
 }  // namespace crypto
 
-int main() {
+int main(int argc, char* argv[]) {
 #ifdef LOCAL
   freopen("input.txt", "r", stdin);
   freopen("output.txt", "w", stdout);
 #endif
+  // Parse options. With --input=FILE the input is mapped into memory and
+  // parsed in place instead of being read from stdin.
+  std::string input_path;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg.rfind("--input=", 0) == 0) {
+      input_path = arg.substr(8);
+    }
+  }
+  std::optional<io::MappedFile> input_file;
+  if (!input_path.empty()) {
+    try {
+      input_file.emplace(input_path);
+    } catch (const std::runtime_error& error) {
+      std::fprintf(stderr, "%s\n", error.what());
+      return 1;
+    }
+  }
+
   // Read input.
+  io::Reader reader = input_file
+                      ? io::Reader(input_file->Data(), input_file->Size())
+                      : io::Reader(stdin);
+  io::Writer writer(stdout);
   uint64_t p, private_key;
-  std::cin >> p >> private_key;
-  std::vector<std::pair<uint64_t, uint64_t>> encrypted_message;
-  uint64_t g_b, encrypted_element;
-  while (std::cin >> g_b >> encrypted_element) {
-    encrypted_message.emplace_back(g_b, encrypted_element);
+  reader.Read(p);
+  reader.Read(private_key);
+  crypto::Decryptor decryptor(math::MontgomeryContext(p), private_key);
+
+  // Output of A with --chunk=N is a sequence of frames
+  // "# <characters> <pairs>", each one is decrypted as soon as it is read.
+  reader.SkipSpaces();
+  if (reader.Peek() == '#') {
+    uint64_t characters, pairs_count;
+    while (reader.Get() == '#' && reader.Read(characters) &&
+           reader.Read(pairs_count)) {
+      std::vector<std::pair<uint64_t, uint64_t>> frame(pairs_count);
+      for (auto& item : frame) {
+        reader.Read(item.first);
+        reader.Read(item.second);
+      }
+      std::string text = crypto::DecryptText(frame, decryptor);
+      // Rebase drops zero digits at the end of the chunk, the header keeps
+      // its real length.
+      text.resize(characters, encoding::DecodeChar(0));
+      writer.Write(text);
+      reader.SkipSpaces();
+    }
+    writer.Write('\n');
+    return 0;
+  }
+
+  // Binary ciphertext written by A with --binary.
+  io::BinaryHeader header{};
+  bool binary = reader.Peek() == io::kBinaryMagic[0];
+  if (binary && !io::ReadBinaryHeader(reader, header)) {
+    std::fprintf(stderr, "Unsupported binary ciphertext\n");
+    return 1;
+  }
+  if (binary && (header.modulus != p || header.degree != 1 ||
+                 header.width != io::ValueWidth(p))) {
+    std::fprintf(stderr, "Binary ciphertext was written for another key\n");
+    return 1;
   }
+  auto read_pair = [&](uint64_t& g_b, uint64_t& encrypted_element) {
+    if (!binary) {
+      return reader.Read(g_b) && reader.Read(encrypted_element);
+    }
+    if (header.count == 0) {
+      return false;
+    }
+    --header.count;
+    return reader.ReadLe(g_b, header.width) &&
+           reader.ReadLe(encrypted_element, header.width);
+  };
 
-  // Decrypt message.
+  // Pairs are decrypted in batches on a worker thread while the rest of the
+  // input is still being parsed.
+  constexpr size_t kBatchSize = 1 << 14;
   std::vector<uint64_t> decrypted_elements;
-  decrypted_elements.reserve(encrypted_message.size());
-  for (auto& item : encrypted_message) {
-    decrypted_elements.push_back(
-            crypto::Decrypt(item, p, private_key));
+  std::future<std::vector<uint64_t>> pending;
+  auto collect = [&]() {
+    if (pending.valid()) {
+      std::vector<uint64_t> decrypted = pending.get();
+      decrypted_elements.insert(decrypted_elements.end(), decrypted.begin(),
+                                decrypted.end());
+    }
+  };
+  std::vector<std::pair<uint64_t, uint64_t>> batch;
+  batch.reserve(kBatchSize);
+  uint64_t g_b, encrypted_element;
+  while (read_pair(g_b, encrypted_element)) {
+    batch.emplace_back(g_b, encrypted_element);
+    if (batch.size() == kBatchSize) {
+      collect();
+      pending = std::async(std::launch::async,
+                           &crypto::Decryptor::DecryptBatch, &decryptor,
+                           std::move(batch));
+      batch = {};
+      batch.reserve(kBatchSize);
+    }
   }
+  collect();
+  std::vector<uint64_t> decrypted = decryptor.DecryptBatch(batch);
+  decrypted_elements.insert(decrypted_elements.end(), decrypted.begin(),
+                            decrypted.end());
 
   // Decode to string.
   math::Number message(p, decrypted_elements);
@@ -210,6 +1286,7 @@ int main() {
   std::string text = encoding::DecodeString(message);
 
   // Write output.
-  std::cout << text << "\n";
+  writer.Write(text);
+  writer.Write('\n');
   return 0;
 }
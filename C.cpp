@@ -1,5 +1,7 @@
+#include <algorithm>
 #include <cstdint>
-#include <iostream>
+#include <cstdio>
+#include <cstring>
 #include <random>
 #include <string>
 #include <utility>
@@ -7,6 +9,8 @@
 
 namespace math {
 
+using uint128 = unsigned __int128;
+
 uint64_t BinPow(uint64_t x, uint64_t y, uint64_t mod) {
   if (y == 0) {
     return 1;
@@ -50,9 +54,9 @@ class Number {
   Number& operator*=(uint64_t num) {
     uint64_t remainder = 0;
     for (size_t i = 0; i < digits_.size(); ++i) {
-      digits_[i] *= num;
-      digits_[i] += remainder;
-      remainder = Split(i);
+      uint128 product = static_cast<uint128>(digits_[i]) * num + remainder;
+      digits_[i] = static_cast<uint64_t>(product % base_);
+      remainder = static_cast<uint64_t>(product / base_);
     }
     digits_.push_back(remainder);
     Normalize();
@@ -103,7 +107,70 @@ class Number {
   std::vector<uint64_t> digits_;
 };
 
-Number Rebase(const Number& num, uint64_t new_base) {
+class MontgomeryContext {
+ public:
+  // Modulus must be odd.
+  explicit MontgomeryContext(uint64_t mod) : mod_(mod), mod_inv_(mod) {
+    // Newton's iteration doubles the number of correct low bits each step.
+    for (int i = 0; i < 5; ++i) {
+      mod_inv_ *= 2 - mod_ * mod_inv_;
+    }
+    r2_ = static_cast<uint64_t>(-static_cast<uint128>(mod_) % mod_);
+  }
+
+  [[nodiscard]] uint64_t Mod() const {
+    return mod_;
+  }
+
+  // Expects x < mod.
+  [[nodiscard]] uint64_t ToMontgomery(uint64_t x) const {
+    return Reduce(static_cast<uint128>(x) * r2_);
+  }
+
+  [[nodiscard]] uint64_t FromMontgomery(uint64_t x) const {
+    return Reduce(x);
+  }
+
+  // Returns a * b * 2^-64. If exactly one of the arguments is in Montgomery
+  // form, the result is the ordinary product.
+  [[nodiscard]] uint64_t Mul(uint64_t a, uint64_t b) const {
+    return Reduce(static_cast<uint128>(a) * b);
+  }
+
+  // Both x and the result are in Montgomery form.
+  [[nodiscard]] uint64_t Pow(uint64_t x, uint64_t y) const {
+    uint64_t result = ToMontgomery(1);
+    while (y > 0) {
+      if ((y & 1) == 1) {
+        result = Mul(result, x);
+      }
+      x = Mul(x, x);
+      y >>= 1;
+    }
+    return result;
+  }
+
+ private:
+  [[nodiscard]] uint64_t Reduce(uint128 t) const {
+    uint64_t m = static_cast<uint64_t>(t) * mod_inv_;
+    uint64_t t_high = static_cast<uint64_t>(t >> 64);
+    uint64_t m_mod_high = static_cast<uint64_t>(
+            (static_cast<uint128>(m) * mod_) >> 64);
+    if (t_high >= m_mod_high) {
+      return t_high - m_mod_high;
+    }
+    return t_high - m_mod_high + mod_;
+  }
+
+  uint64_t mod_;
+  uint64_t mod_inv_;
+  uint64_t r2_;
+};
+
+
+// Schoolbook conversion, used for short numbers and as the recursion leaf of
+// Rebase.
+Number RebaseQuadratic(const Number& num, uint64_t new_base) {
   Number new_number(new_base, {0});
   for (size_t i = num.Size(); i > 0; --i) {
     new_number *= num.Base();
@@ -112,6 +179,275 @@ Number Rebase(const Number& num, uint64_t new_base) {
   return new_number;
 }
 
+struct NttPrime {
+  uint64_t mod;
+  uint64_t root;
+};
+
+// Primes of the form c * 2^k + 1 with k >= 54 and their primitive roots. The
+// product of the three exceeds 2^183, which is enough to restore convolutions
+// of digits below 2^63 exactly.
+constexpr NttPrime kNttPrimes[] = {{4179340454199820289, 3},
+                                   {2485986994308513793, 5},
+                                   {2936346957045563393, 3}};
+
+// In-place transform of a vector in Montgomery form, size is a power of two.
+void Ntt(std::vector<uint64_t>& a, const MontgomeryContext& context,
+         uint64_t root, bool invert) {
+  size_t n = a.size();
+  for (size_t i = 1, j = 0; i < n; ++i) {
+    size_t bit = n >> 1;
+    for (; (j & bit) != 0; bit >>= 1) {
+      j ^= bit;
+    }
+    j ^= bit;
+    if (i < j) {
+      std::swap(a[i], a[j]);
+    }
+  }
+  uint64_t mod = context.Mod();
+  uint64_t root_mont = context.ToMontgomery(root);
+  std::vector<uint64_t> twiddles(n / 2);
+  for (size_t len = 2; len <= n; len <<= 1) {
+    uint64_t exponent = (mod - 1) / len;
+    uint64_t w_len = context.Pow(root_mont,
+                                 invert ? mod - 1 - exponent : exponent);
+    size_t half = len / 2;
+    twiddles[0] = context.ToMontgomery(1);
+    for (size_t j = 1; j < half; ++j) {
+      twiddles[j] = context.Mul(twiddles[j - 1], w_len);
+    }
+    for (size_t i = 0; i < n; i += len) {
+      for (size_t j = 0; j < half; ++j) {
+        uint64_t u = a[i + j];
+        uint64_t v = context.Mul(a[i + j + half], twiddles[j]);
+        a[i + j] = u + v >= mod ? u + v - mod : u + v;
+        a[i + j + half] = u >= v ? u - v : u + mod - v;
+      }
+    }
+  }
+}
+
+std::vector<uint64_t> ConvolveModPrime(const std::vector<uint64_t>& a,
+                                       const std::vector<uint64_t>& b,
+                                       const NttPrime& prime, size_t size) {
+  MontgomeryContext context(prime.mod);
+  std::vector<uint64_t> fa(size), fb(size);
+  for (size_t i = 0; i < a.size(); ++i) {
+    fa[i] = context.ToMontgomery(a[i] % prime.mod);
+  }
+  for (size_t i = 0; i < b.size(); ++i) {
+    fb[i] = context.ToMontgomery(b[i] % prime.mod);
+  }
+  Ntt(fa, context, prime.root, /*invert=*/false);
+  Ntt(fb, context, prime.root, /*invert=*/false);
+  for (size_t i = 0; i < size; ++i) {
+    fa[i] = context.Mul(fa[i], fb[i]);
+  }
+  Ntt(fa, context, prime.root, /*invert=*/true);
+  uint64_t size_inv = context.FromMontgomery(
+          context.Pow(context.ToMontgomery(size % prime.mod), prime.mod - 2));
+  for (size_t i = 0; i < size; ++i) {
+    fa[i] = context.Mul(fa[i], size_inv);
+  }
+  return fa;
+}
+
+void TrimDigits(std::vector<uint64_t>& digits) {
+  while (digits.size() > 1 && digits.back() == 0) {
+    digits.pop_back();
+  }
+}
+
+std::vector<uint64_t> AddDigits(const std::vector<uint64_t>& a,
+                                const std::vector<uint64_t>& b,
+                                uint64_t base) {
+  std::vector<uint64_t> result(std::max(a.size(), b.size()) + 1);
+  uint64_t carry = 0;
+  for (size_t i = 0; i + 1 < result.size(); ++i) {
+    uint64_t sum = carry;
+    sum += i < a.size() ? a[i] : 0;
+    sum += i < b.size() ? b[i] : 0;
+    carry = sum >= base ? 1 : 0;
+    result[i] = sum - carry * base;
+  }
+  result.back() = carry;
+  TrimDigits(result);
+  return result;
+}
+
+std::vector<uint64_t> MulDigits(const std::vector<uint64_t>& a,
+                                const std::vector<uint64_t>& b,
+                                uint64_t base) {
+  std::vector<uint64_t> result(a.size() + b.size());
+  if (std::min(a.size(), b.size()) <= 32) {
+    for (size_t i = 0; i < a.size(); ++i) {
+      uint64_t carry = 0;
+      for (size_t j = 0; j < b.size(); ++j) {
+        uint128 cur = static_cast<uint128>(a[i]) * b[j] + result[i + j] +
+                      carry;
+        result[i + j] = static_cast<uint64_t>(cur % base);
+        carry = static_cast<uint64_t>(cur / base);
+      }
+      result[i + b.size()] = carry;
+    }
+    TrimDigits(result);
+    return result;
+  }
+
+  size_t size = 1;
+  while (size < a.size() + b.size()) {
+    size <<= 1;
+  }
+  std::vector<uint64_t> residues[3];
+  for (int k = 0; k < 3; ++k) {
+    residues[k] = ConvolveModPrime(a, b, kNttPrimes[k], size);
+  }
+
+  // Restore every coefficient with Garner's algorithm as a 192-bit value
+  // x = a0 + a1 * m0 + a2 * m0 * m1 and propagate carries in the new base.
+  uint64_t m0 = kNttPrimes[0].mod;
+  uint64_t m1 = kNttPrimes[1].mod;
+  uint64_t m2 = kNttPrimes[2].mod;
+  MontgomeryContext context1(m1), context2(m2);
+  uint64_t m0_inv_mod_m1 = context1.Pow(context1.ToMontgomery(m0 % m1),
+                                        m1 - 2);
+  uint64_t m0_mod_m2 = context2.ToMontgomery(m0 % m2);
+  uint64_t m0_m1_inv_mod_m2 = context2.Pow(
+          context2.Mul(m0_mod_m2, context2.ToMontgomery(m1 % m2)), m2 - 2);
+  uint128 m0_m1 = static_cast<uint128>(m0) * m1;
+  uint128 carry = 0;
+  for (size_t i = 0; i + 1 < result.size(); ++i) {
+    uint64_t a0 = residues[0][i];
+    uint64_t a0_mod_m1 = a0 % m1;
+    uint64_t r1 = residues[1][i];
+    uint64_t a1 = context1.Mul(
+            r1 >= a0_mod_m1 ? r1 - a0_mod_m1 : r1 + m1 - a0_mod_m1,
+            m0_inv_mod_m1);
+    uint64_t known = a0 % m2 + context2.Mul(a1, m0_mod_m2);
+    known = known >= m2 ? known - m2 : known;
+    uint64_t r2 = residues[2][i];
+    uint64_t a2 = context2.Mul(r2 >= known ? r2 - known : r2 + m2 - known,
+                               m0_m1_inv_mod_m2);
+
+    uint128 low = static_cast<uint128>(a2) * static_cast<uint64_t>(m0_m1);
+    uint128 high = static_cast<uint128>(a2) *
+                   static_cast<uint64_t>(m0_m1 >> 64) + (low >> 64);
+    uint64_t limbs[3] = {static_cast<uint64_t>(low),
+                         static_cast<uint64_t>(high),
+                         static_cast<uint64_t>(high >> 64)};
+    for (uint128 term : {static_cast<uint128>(a1) * m0,
+                         static_cast<uint128>(a0), carry}) {
+      uint128 sum = static_cast<uint128>(limbs[0]) +
+                    static_cast<uint64_t>(term);
+      limbs[0] = static_cast<uint64_t>(sum);
+      sum = static_cast<uint128>(limbs[1]) + static_cast<uint64_t>(term >> 64) +
+            (sum >> 64);
+      limbs[1] = static_cast<uint64_t>(sum);
+      limbs[2] += static_cast<uint64_t>(sum >> 64);
+    }
+
+    // The quotient is below base * size, so it fits into 128 bits.
+    uint128 remainder = limbs[2] % base;
+    uint128 cur = (remainder << 64) | limbs[1];
+    uint64_t quotient_high = static_cast<uint64_t>(cur / base);
+    cur = ((cur % base) << 64) | limbs[0];
+    uint64_t quotient_low = static_cast<uint64_t>(cur / base);
+    result[i] = static_cast<uint64_t>(cur % base);
+    carry = (static_cast<uint128>(quotient_high) << 64) | quotient_low;
+  }
+  result.back() = static_cast<uint64_t>(carry);
+  TrimDigits(result);
+  return result;
+}
+
+constexpr size_t kRebaseLeafSize = 64;
+
+// Converts digits [begin, begin + kRebaseLeafSize * 2^level) of the source
+// number. powers[k] holds base^(kRebaseLeafSize * 2^k) in the new base.
+std::vector<uint64_t>
+RebaseRange(const std::vector<uint64_t>& digits, size_t begin, size_t level,
+            uint64_t base, uint64_t new_base,
+            const std::vector<std::vector<uint64_t>>& powers) {
+  size_t end = std::min(digits.size(), begin + (kRebaseLeafSize << level));
+  if (level == 0) {
+    Number leaf(base, std::vector<uint64_t>(digits.begin() + begin,
+                                            digits.begin() + end));
+    return RebaseQuadratic(leaf, new_base).GetDigits();
+  }
+  size_t middle = begin + (kRebaseLeafSize << (level - 1));
+  if (middle >= end) {
+    return RebaseRange(digits, begin, level - 1, base, new_base, powers);
+  }
+  std::vector<uint64_t> low = RebaseRange(digits, begin, level - 1, base,
+                                          new_base, powers);
+  std::vector<uint64_t> high = RebaseRange(digits, middle, level - 1, base,
+                                           new_base, powers);
+  return AddDigits(low, MulDigits(high, powers[level - 1], new_base),
+                   new_base);
+}
+
+// Largest power base^width below 2^63. Small bases are packed into it, which
+// shortens the digit vectors Rebase works on.
+std::pair<uint64_t, size_t> PackedBase(uint64_t base) {
+  uint64_t packed_base = base;
+  size_t width = 1;
+  while (packed_base <= (uint64_t{1} << 63) / base) {
+    packed_base *= base;
+    ++width;
+  }
+  return {packed_base, width};
+}
+
+std::vector<uint64_t> PackDigits(const std::vector<uint64_t>& digits,
+                                 uint64_t base, size_t width) {
+  std::vector<uint64_t> packed((digits.size() + width - 1) / width);
+  for (size_t i = digits.size(); i > 0; --i) {
+    packed[(i - 1) / width] = packed[(i - 1) / width] * base + digits[i - 1];
+  }
+  return packed;
+}
+
+std::vector<uint64_t> UnpackDigits(const std::vector<uint64_t>& packed,
+                                   uint64_t base, size_t width) {
+  std::vector<uint64_t> digits;
+  digits.reserve(packed.size() * width);
+  for (uint64_t item : packed) {
+    for (size_t j = 0; j < width; ++j) {
+      digits.push_back(item % base);
+      item /= base;
+    }
+  }
+  TrimDigits(digits);
+  return digits;
+}
+
+// Divide-and-conquer radix conversion: both halves of the number are
+// converted recursively and joined by a multiplication by a precomputed power
+// of the old base. With NTT multiplication this takes O(n log^2 n).
+Number Rebase(const Number& num, uint64_t new_base) {
+  if (num.Size() <= kRebaseLeafSize) {
+    return RebaseQuadratic(num, new_base);
+  }
+  auto [base, width] = PackedBase(num.Base());
+  auto [packed_new_base, new_width] = PackedBase(new_base);
+  std::vector<uint64_t> digits = PackDigits(num.GetDigits(), num.Base(),
+                                            width);
+  std::vector<uint64_t> leaf_power(kRebaseLeafSize + 1);
+  leaf_power.back() = 1;
+  std::vector<std::vector<uint64_t>> powers = {
+          RebaseQuadratic(Number(base, leaf_power), packed_new_base)
+                  .GetDigits()};
+  while ((kRebaseLeafSize << powers.size()) < digits.size()) {
+    powers.push_back(MulDigits(powers.back(), powers.back(),
+                               packed_new_base));
+  }
+  std::vector<uint64_t> result = RebaseRange(digits, /*begin=*/0,
+                                             /*level=*/powers.size(), base,
+                                             packed_new_base, powers);
+  return {new_base, UnpackDigits(result, new_base, new_width)};
+}
+
 class Fq {
  public:
   explicit Fq(uint64_t p, std::vector<uint64_t> coefficients,
@@ -312,68 +648,387 @@ Encrypt(const math::Fq& message, const math::Fq& g, const math::Fq& public_key,
 
 }  // namespace crypto
 
-namespace string_utils {
+namespace io {
 
-std::vector<uint64_t>
-SplitAndCastToUint64(const std::string& line, uint64_t p) {
-  // Split line into tokens.
-  std::vector<std::string> tokens;
-  std::string cur_token;
-  for (char c : line) {
-    if (c == ' ') {
-      tokens.push_back(cur_token);
-      cur_token = "";
-    } else {
-      cur_token += c;
+constexpr size_t kBufferSize = 1 << 16;
+
+// Buffered input on top of fread with hand-rolled integer parsing. It can
+// also parse a memory region in place, e.g. a mapped file.
+class Reader {
+ public:
+  explicit Reader(FILE* file)
+          : file_(file), buffer_(kBufferSize), data_(buffer_.data()) {}
+
+  Reader(const char* data, size_t size)
+          : file_(nullptr), data_(data), size_(size) {}
+
+  Reader(const Reader&) = delete;
+  Reader& operator=(const Reader&) = delete;
+
+  // Returns the next character without extracting it, or EOF.
+  int Peek() {
+    if (pos_ == size_ && !Refill()) {
+      return EOF;
     }
+    return static_cast<unsigned char>(data_[pos_]);
   }
-  if (!cur_token.empty()) {
-    tokens.push_back(cur_token);
+
+  int Get() {
+    int c = Peek();
+    if (c != EOF) {
+      ++pos_;
+    }
+    return c;
   }
-  // Convert each token to uint64_t.
+
+  void SkipSpaces() {
+    for (int c = Peek(); c == ' ' || c == '\n' || c == '\r' || c == '\t';
+         c = Peek()) {
+      ++pos_;
+    }
+  }
+
+  // Reads an unsigned decimal number, returns false if there is none.
+  bool Read(uint64_t& x) {
+    SkipSpaces();
+    int c = Peek();
+    if (c < '0' || c > '9') {
+      return false;
+    }
+    x = 0;
+    for (; c >= '0' && c <= '9'; c = Peek()) {
+      x = x * 10 + (c - '0');
+      ++pos_;
+    }
+    return true;
+  }
+
+  // Reads a whitespace-separated token, returns false at the end of input.
+  bool ReadToken(std::string& token) {
+    SkipSpaces();
+    token.clear();
+    for (int c = Peek(); c != EOF && c != ' ' && c != '\n' && c != '\r' &&
+                         c != '\t'; c = Peek()) {
+      token.push_back(static_cast<char>(c));
+      ++pos_;
+    }
+    return !token.empty();
+  }
+
+  // Reads the rest of the current line and extracts the line break. Returns
+  // false at the end of input.
+  bool ReadLine(std::string& line) {
+    line.clear();
+    if (Peek() == EOF) {
+      return false;
+    }
+    while (pos_ < size_ || Refill()) {
+      const char* begin = data_ + pos_;
+      const char* end = static_cast<const char*>(
+              std::memchr(begin, '\n', size_ - pos_));
+      if (end != nullptr) {
+        line.append(begin, end);
+        pos_ += end - begin + 1;
+        return true;
+      }
+      line.append(begin, size_ - pos_);
+      pos_ = size_;
+    }
+    return true;
+  }
+
+  // Reads up to n next characters of the current line, leaving the line
+  // break in place. Returns false when the line is exhausted.
+  bool ReadLineChunk(std::string& chunk, size_t n) {
+    chunk.clear();
+    while (chunk.size() < n && (pos_ < size_ || Refill())) {
+      const char* begin = data_ + pos_;
+      size_t available = std::min(size_ - pos_, n - chunk.size());
+      const char* end = static_cast<const char*>(
+              std::memchr(begin, '\n', available));
+      if (end != nullptr) {
+        chunk.append(begin, end);
+        pos_ += end - begin;
+        break;
+      }
+      chunk.append(begin, available);
+      pos_ += available;
+    }
+    return !chunk.empty();
+  }
+
+  // Reads n raw bytes, returns false if the input ends earlier.
+  bool ReadBytes(void* data, size_t n) {
+    auto* out = static_cast<char*>(data);
+    while (n > 0 && (pos_ < size_ || Refill())) {
+      size_t available = std::min(size_ - pos_, n);
+      std::memcpy(out, data_ + pos_, available);
+      pos_ += available;
+      out += available;
+      n -= available;
+    }
+    return n == 0;
+  }
+
+  // Reads a little-endian integer of the given width in bytes.
+  bool ReadLe(uint64_t& x, size_t bytes = sizeof(uint64_t)) {
+    uint8_t buffer[sizeof(uint64_t)];
+    if (!ReadBytes(buffer, bytes)) {
+      return false;
+    }
+    x = 0;
+    for (size_t i = bytes; i > 0; --i) {
+      x = (x << 8) | buffer[i - 1];
+    }
+    return true;
+  }
+
+ private:
+  bool Refill() {
+    if (file_ == nullptr) {
+      return false;
+    }
+    pos_ = 0;
+    size_ = std::fread(buffer_.data(), 1, buffer_.size(), file_);
+    return size_ > 0;
+  }
+
+  FILE* file_;
+  std::vector<char> buffer_;
+  const char* data_;
+  size_t pos_ = 0;
+  size_t size_ = 0;
+};
+
+// Buffered output on top of fwrite, flushed on destruction.
+class Writer {
+ public:
+  explicit Writer(FILE* file) : file_(file), buffer_(kBufferSize) {}
+
+  Writer(const Writer&) = delete;
+  Writer& operator=(const Writer&) = delete;
+
+  ~Writer() {
+    Flush();
+  }
+
+  void Write(char c) {
+    if (pos_ == buffer_.size()) {
+      Flush();
+    }
+    buffer_[pos_++] = c;
+  }
+
+  void Write(uint64_t x) {
+    char digits[20];
+    size_t n = 0;
+    do {
+      digits[n++] = static_cast<char>('0' + x % 10);
+      x /= 10;
+    } while (x > 0);
+    if (buffer_.size() - pos_ < n) {
+      Flush();
+    }
+    while (n > 0) {
+      buffer_[pos_++] = digits[--n];
+    }
+  }
+
+  void Write(const std::string& s) {
+    WriteBytes(s.data(), s.size());
+  }
+
+  void WriteBytes(const void* data, size_t n) {
+    const auto* in = static_cast<const char*>(data);
+    for (size_t written = 0; written < n;) {
+      if (pos_ == buffer_.size()) {
+        Flush();
+      }
+      size_t count = std::min(n - written, buffer_.size() - pos_);
+      std::memcpy(buffer_.data() + pos_, in + written, count);
+      pos_ += count;
+      written += count;
+    }
+  }
+
+  // Writes the lowest bytes of x in little-endian order.
+  void WriteLe(uint64_t x, size_t bytes = sizeof(uint64_t)) {
+    uint8_t buffer[sizeof(uint64_t)];
+    for (size_t i = 0; i < bytes; ++i) {
+      buffer[i] = static_cast<uint8_t>(x >> (8 * i));
+    }
+    WriteBytes(buffer, bytes);
+  }
+
+  void Flush() {
+    std::fwrite(buffer_.data(), 1, pos_, file_);
+    pos_ = 0;
+  }
+
+ private:
+  FILE* file_;
+  std::vector<char> buffer_;
+  size_t pos_ = 0;
+};
+
+// Binary ciphertext format, version 1. All integers are little-endian:
+//   "EGCT", u32 version, u32 value width in bytes, u32 values per element
+//   (the field degree), u64 modulus, u64 number of pairs,
+// followed by the pairs, each element stored as exactly that many values of
+// the smallest width that fits the modulus. E writes version 2, which stores
+// a 256-bit modulus.
+constexpr char kBinaryMagic[4] = {'E', 'G', 'C', 'T'};
+constexpr uint64_t kBinaryVersion = 1;
+
+struct BinaryHeader {
+  uint64_t width;
+  uint64_t degree;
+  uint64_t modulus;
+  uint64_t count;
+};
+
+// Number of bytes needed to store values below the modulus.
+uint64_t ValueWidth(uint64_t modulus) {
+  uint64_t width = 1;
+  while (width < sizeof(uint64_t) && (modulus - 1) >> (8 * width) != 0) {
+    ++width;
+  }
+  return width;
+}
+
+void WriteBinaryHeader(Writer& writer, const BinaryHeader& header) {
+  writer.WriteBytes(kBinaryMagic, sizeof(kBinaryMagic));
+  writer.WriteLe(kBinaryVersion, 4);
+  writer.WriteLe(header.width, 4);
+  writer.WriteLe(header.degree, 4);
+  writer.WriteLe(header.modulus);
+  writer.WriteLe(header.count);
+}
+
+// Returns false if the input is not a supported binary ciphertext.
+bool ReadBinaryHeader(Reader& reader, BinaryHeader& header) {
+  char magic[sizeof(kBinaryMagic)];
+  uint64_t version;
+  return reader.ReadBytes(magic, sizeof(magic)) &&
+         std::memcmp(magic, kBinaryMagic, sizeof(magic)) == 0 &&
+         reader.ReadLe(version, 4) && version == kBinaryVersion &&
+         reader.ReadLe(header.width, 4) && header.width > 0 &&
+         header.width <= sizeof(uint64_t) &&
+         reader.ReadLe(header.degree, 4) && reader.ReadLe(header.modulus) &&
+         reader.ReadLe(header.count);
+}
+
+}  // namespace io
+
+namespace string_utils {
+
+std::vector<uint64_t>
+SplitAndCastToUint64(const std::string& line, uint64_t p) {
+  // Parse space-separated, possibly negative integers.
   std::vector<uint64_t> coefficients;
-  coefficients.reserve(tokens.size());
-  for (const std::string& token : tokens) {
-    int64_t coefficient = std::stoll(token);
-    if (coefficient < 0) {
-      coefficient += p;
+  for (size_t i = 0; i < line.size();) {
+    if (line[i] == ' ' || line[i] == '\r') {
+      ++i;
+      continue;
+    }
+    bool negative = line[i] == '-';
+    if (negative) {
+      ++i;
+    }
+    uint64_t coefficient = 0;
+    for (; i < line.size() && line[i] >= '0' && line[i] <= '9'; ++i) {
+      coefficient = coefficient * 10 + (line[i] - '0');
+    }
+    if (negative && coefficient != 0) {
+      coefficient = p - coefficient;
     }
     coefficients.push_back(coefficient);
   }
   return coefficients;
 }
 
-std::vector<uint64_t> ReadPolynomial(std::istream& input, uint64_t p) {
+std::vector<uint64_t> ReadPolynomial(io::Reader& input, uint64_t p) {
   std::string coefficients;
-  std::getline(input, coefficients);
+  input.ReadLine(coefficients);
   return SplitAndCastToUint64(coefficients, p);
 }
 
-void PrintFq(std::ostream& output, const math::Fq& fq) {
+void PrintFq(io::Writer& output, const math::Fq& fq) {
   for (size_t i = 0; i < fq.GetN(); ++i) {
-    output << fq[i] << " ";
+    output.Write(fq[i]);
+    output.Write(' ');
+  }
+  output.Write('\n');
+}
+
+// Writes exactly n coefficients of the given width, padding with zeros.
+void WriteFqBinary(io::Writer& output, const math::Fq& fq, size_t n,
+                   size_t width) {
+  for (size_t i = 0; i < n; ++i) {
+    output.WriteLe(i < fq.GetN() ? fq[i] : 0, width);
   }
-  output << "\n";
 }
 
 }  // namespace string_utils
 
-int main() {
+int main(int argc, char* argv[]) {
 #ifdef LOCAL
   freopen("input.txt", "r", stdin);
   freopen("output.txt", "w", stdout);
 #endif
-  // Read input.
-  uint64_t p;
-  std::cin >> p;
-  std::cin.ignore();
-  std::vector<uint64_t> f = string_utils::ReadPolynomial(std::cin, p);
-  math::Fq g(p, /*coefficients=*/string_utils::ReadPolynomial(std::cin, p),
+  // Parse options. Streaming mode is enabled by --chunk=N. With --binary the
+  // whole-message output uses the binary format.
+  size_t chunk_size = 0;
+  bool binary = false;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg.rfind("--chunk=", 0) == 0) {
+      chunk_size = std::stoull(arg.substr(8));
+    } else if (arg == "--binary") {
+      binary = true;
+    }
+  }
+
+  // Read keys.
+  io::Reader reader(stdin);
+  io::Writer writer(stdout);
+  uint64_t p = 0;
+  reader.Read(p);
+  reader.Get();
+  std::vector<uint64_t> f = string_utils::ReadPolynomial(reader, p);
+  math::Fq g(p, /*coefficients=*/string_utils::ReadPolynomial(reader, p),
           /*base=*/f);
   math::Fq public_key(p, /*coefficients=*/
-                      string_utils::ReadPolynomial(std::cin, p), /*base=*/f);
+                      string_utils::ReadPolynomial(reader, p), /*base=*/f);
+  std::mt19937 gen;
+
+  if (chunk_size > 0) {
+    // Every chunk of the text is encoded and encrypted on its own and written
+    // as a frame "# <characters> <blocks>" followed by its blocks.
+    std::string chunk;
+    while (reader.ReadLineChunk(chunk, chunk_size)) {
+      math::Number message = encoding::EncodeString(chunk);
+      message = math::Rebase(message, /*new_base=*/p);
+      std::vector<math::Fq> blocks = encoding::SplitBlocks(
+              message.GetDigits(), /*n=*/f.size() - 1, /*base=*/f, p);
+      writer.Write('#');
+      writer.Write(' ');
+      writer.Write(uint64_t{chunk.size()});
+      writer.Write(' ');
+      writer.Write(uint64_t{blocks.size()});
+      writer.Write('\n');
+      for (const math::Fq& block : blocks) {
+        auto item = crypto::Encrypt(block, g, public_key, gen);
+        string_utils::PrintFq(writer, item.first);
+        string_utils::PrintFq(writer, item.second);
+      }
+    }
+    return 0;
+  }
+
+  // Read message.
   std::string text;
-  std::getline(std::cin, text);
+  reader.ReadLine(text);
 
   // Get a sequence for encryption.
   math::Number message = encoding::EncodeString(text);
@@ -384,15 +1039,27 @@ int main() {
   // Encrypt.
   std::vector<std::pair<math::Fq, math::Fq>> encrypted;
   encrypted.reserve(blocks.size());
-  std::mt19937 gen;
   for (const math::Fq& block : blocks) {
     encrypted.push_back(crypto::Encrypt(block, g, public_key, gen));
   }
 
   // Write output.
+  if (binary) {
+    io::BinaryHeader header{/*width=*/io::ValueWidth(p),
+                            /*degree=*/f.size() - 1, /*modulus=*/p,
+                            /*count=*/encrypted.size()};
+    io::WriteBinaryHeader(writer, header);
+    for (const auto& item : encrypted) {
+      string_utils::WriteFqBinary(writer, item.first, header.degree,
+                                  header.width);
+      string_utils::WriteFqBinary(writer, item.second, header.degree,
+                                  header.width);
+    }
+    return 0;
+  }
   for (const auto& item : encrypted) {
-    string_utils::PrintFq(std::cout, item.first);
-    string_utils::PrintFq(std::cout, item.second);
+    string_utils::PrintFq(writer, item.first);
+    string_utils::PrintFq(writer, item.second);
   }
   return 0;
 }
@@ -4,7 +4,7 @@
 #include <climits>
 #include <cstdint>
 #include <cstring>
-#include <iostream>
+#include <cstdio>
 #include <limits>
 #include <random>
 #include <stdexcept>
@@ -21,6 +21,13 @@
 #include <intrin.h>
 #endif
 
+#if defined(__x86_64__) && defined(__GNUC__)
+#define HAS_X86_SIMD 1
+#include <immintrin.h>
+#else
+#define HAS_X86_SIMD 0
+#endif
+
 #if !defined(__has_builtin)
 #define __has_builtin(NAME) 0
 #endif
@@ -862,7 +869,7 @@ struct uint {
   constexpr explicit operator bool() const noexcept { return *this != uint{}; }
 
   template<unsigned M, typename = typename std::enable_if_t<(M < N)>>
-  explicit operator uint<M>() const noexcept {
+  constexpr explicit operator uint<M>() const noexcept {
     uint<M> r;
     for (size_t i = 0; i < uint<M>::num_words; ++i)
       r[i] = words_[i];
@@ -1578,6 +1585,119 @@ inline constexpr uint<N>& operator%=(uint<N>& x, const T& y) noexcept {
   return x = x % y;
 }
 
+/// Barrett reduction modulo a fixed m (HAC 14.42). The reciprocal
+/// (b^(2k) - 1) / m, where b = 2^64 and m has k significant words, is computed
+/// once, so a modular product then costs two partial multiplications instead
+/// of a long division.
+template<unsigned N>
+class barrett_context {
+  static constexpr auto num_words = uint<N>::num_words;
+
+ public:
+  explicit barrett_context(const uint<N>& mod) noexcept
+          : mod_{mod}, k_{count_significant_words(mod)} {
+    INTX_REQUIRE(mod != 0);
+    // b^(2k) / m itself needs k + 2 words when m is a power of b. One less
+    // always fits in k + 1 and only costs one more correction step.
+    mu_ = static_cast<uint<N + 64>>(
+            ((uint<2 * N + 128>{1} << (128 * k_)) - 1) / uint<2 * N + 128>{mod});
+  }
+
+  const uint<N>& mod() const noexcept { return mod_; }
+
+  /// Returns x mod m for x < b^(2k), in particular for any product of two
+  /// residues.
+  uint<N> reduce(const uint<2 * N>& x) const noexcept {
+    // With a full-width modulus the loop bounds are constants.
+    if (k_ == num_words)
+      return reduce_words(x, num_words);
+    return reduce_words(x, k_);
+  }
+
+  /// Returns x * y mod m for x, y < m.
+  uint<N> mulmod(const uint<N>& x, const uint<N>& y) const noexcept {
+    return reduce(umul(x, y));
+  }
+
+  /// Returns x^2 mod m for x < m.
+  uint<N> sqrmod(const uint<N>& x) const noexcept { return mulmod(x, x); }
+
+  /// Returns base^exponent mod m for base < m.
+  uint<N> powmod(const uint<N>& base, const uint<N>& exponent) const noexcept {
+    auto result = reduce(uint<2 * N>{1});
+    for (auto i = N - clz(exponent); i > 0; --i) {
+      result = sqrmod(result);
+      if (((exponent[(i - 1) / 64] >> ((i - 1) % 64)) & 1) != 0)
+        result = mulmod(result, base);
+    }
+    return result;
+  }
+
+ private:
+  [[gnu::always_inline]] uint<N> reduce_words(
+          const uint<2 * N>& x, size_t k) const noexcept {
+    // q = (x / b^(k-1)) mu / b^(k+1) is below x / m by at most 3. Words of
+    // the product below k - 1 are skipped, which costs at most one more.
+    uint64_t q[2 * num_words + 2]{};
+    for (size_t i = 0; i <= k; ++i) {
+      uint64_t carry = 0;
+      for (size_t j = i + 1 < k ? k - 1 - i : 0; j <= k; ++j) {
+        const auto t = umul(x[k - 1 + i], mu_[j]) + q[i + j] + carry;
+        q[i + j] = t[0];
+        carry = t[1];
+      }
+      q[i + k + 1] = carry;
+    }
+
+    // r = x - q m mod b^(k+1).
+    uint64_t qm[num_words + 1]{};
+    for (size_t i = 0; i <= k; ++i) {
+      uint64_t carry = 0;
+      for (size_t j = 0; j < k && i + j <= k; ++j) {
+        const auto t = umul(q[k + 1 + i], mod_[j]) + qm[i + j] + carry;
+        qm[i + j] = t[0];
+        carry = t[1];
+      }
+      if (i == 0)
+        qm[k] = carry;
+    }
+    uint64_t r[num_words + 1]{};
+    bool borrow = false;
+    for (size_t i = 0; i <= k; ++i) {
+      const auto s = sub_with_carry(x[i], qm[i], borrow);
+      r[i] = s.value;
+      borrow = s.carry;
+    }
+
+    while (!less_than_mod(r, k)) {
+      borrow = false;
+      for (size_t i = 0; i <= k; ++i) {
+        const auto s = sub_with_carry(r[i], i < k ? mod_[i] : 0, borrow);
+        r[i] = s.value;
+        borrow = s.carry;
+      }
+    }
+    uint<N> result;
+    for (size_t i = 0; i < k; ++i)
+      result[i] = r[i];
+    return result;
+  }
+
+  bool less_than_mod(const uint64_t r[], size_t k) const noexcept {
+    if (r[k] != 0)
+      return false;
+    for (size_t i = k; i > 0; --i) {
+      if (r[i - 1] != mod_[i - 1])
+        return r[i - 1] < mod_[i - 1];
+    }
+    return false;
+  }
+
+  uint<N> mod_;
+  unsigned k_;
+  uint<N + 64> mu_;
+};
+
 template<unsigned N>
 inline constexpr uint<N> bswap(const uint<N>& x) noexcept {
   constexpr auto num_words = uint<N>::num_words;
@@ -1822,209 +1942,1491 @@ inline void store(uint8_t* dst, const intx::uint<N>& x) noexcept {
 
 namespace math {
 
-class Number {
- public:
-  Number(uint64_t base, std::vector<uint64_t> digits) : base_(base),
-                                                        digits_(std::move(
-                                                                digits)) {}
+using intx::operator ""_u256;
+using intx::operator ""_u512;
 
-  Number& operator+=(uint64_t num) {
-    digits_[0] += num;
-    Normalize();
-    return *this;
-  }
+using int128 = __int128;
+using uint128 = unsigned __int128;
+
+const int64_t kLimbMask62 = (int64_t{1} << 62) - 1;
+
+// Transition matrix of 62 divsteps: it maps (f, g) to
+// ((u f + v g) / 2^62, (q f + r g) / 2^62).
+struct DivstepMatrix {
+  int64_t u;
+  int64_t v;
+  int64_t q;
+  int64_t r;
+};
 
-  Number& operator*=(uint64_t num) {
-    uint64_t remainder = 0;
-    for (size_t i = 0; i < digits_.size(); ++i) {
-      digits_[i] *= num;
-      digits_[i] += remainder;
-      remainder = Split(i);
+// Runs 62 divsteps on the low bits of f and g, skipping runs of zero bits of
+// g at once. eta is minus the delta of the Bernstein-Yang paper.
+int64_t Divsteps62(int64_t eta, uint64_t f, uint64_t g,
+                   DivstepMatrix& matrix) {
+  uint64_t u = 1;
+  uint64_t v = 0;
+  uint64_t q = 0;
+  uint64_t r = 1;
+  int i = 62;
+  while (true) {
+    int zeros = __builtin_ctzll(g | (UINT64_MAX << i));
+    g >>= zeros;
+    u <<= zeros;
+    v <<= zeros;
+    eta -= zeros;
+    i -= zeros;
+    if (i == 0) {
+      break;
     }
-    digits_.push_back(remainder);
-    Normalize();
-    return *this;
+    uint64_t w;
+    if (eta < 0) {
+      eta = -eta;
+      uint64_t tmp = f;
+      f = g;
+      g = -tmp;
+      tmp = u;
+      u = q;
+      q = -tmp;
+      tmp = v;
+      v = r;
+      r = -tmp;
+      int limit = std::min(static_cast<int>(eta) + 1, i);
+      uint64_t mask = (UINT64_MAX >> (64 - limit)) & 63;
+      w = (f * g * (f * f - 2)) & mask;
+    } else {
+      int limit = std::min(static_cast<int>(eta) + 1, i);
+      uint64_t mask = (UINT64_MAX >> (64 - limit)) & 15;
+      w = f + (((f + 1) & 4) << 1);
+      w = (-w * g) & mask;
+    }
+    g += f * w;
+    q += u * w;
+    r += v * w;
   }
+  matrix = {static_cast<int64_t>(u), static_cast<int64_t>(v),
+            static_cast<int64_t>(q), static_cast<int64_t>(r)};
+  return eta;
+}
 
-  [[nodiscard]] size_t Size() const {
-    return digits_.size();
+// Modular inversion by Bernstein-Yang divsteps (safegcd) over W-word numbers.
+// Values are kept in L signed 62-bit limbs: every limb but the top one is in
+// [0, 2^62), the top one carries the sign.
+template<size_t W>
+class SafeGcd {
+ public:
+  static constexpr size_t kLimbs = 64 * W / 62 + 1;
+  using Limbs = std::array<int64_t, kLimbs>;
+
+  // Writes a^-1 modulo an odd mod into result, or 0 for a = 0. Expects
+  // gcd(a, mod) = 1.
+  static void Inverse(const uint64_t* a, const uint64_t* mod,
+                      uint64_t* result) {
+    Limbs modulus = ToLimbs(mod);
+    uint64_t mod_inv = mod[0];
+    for (size_t i = 0; i < 5; ++i) {
+      mod_inv *= 2 - mod[0] * mod_inv;
+    }
+    mod_inv &= kLimbMask62;
+
+    // Invariants: d * a = f and e * a = g modulo mod.
+    Limbs d{};
+    Limbs e{};
+    e[0] = 1;
+    Limbs f = modulus;
+    Limbs g = ToLimbs(a);
+    size_t len = kLimbs;
+    int64_t eta = -1;
+    while (true) {
+      DivstepMatrix matrix{};
+      eta = Divsteps62(eta, f[0], g[0], matrix);
+      UpdateDe(d, e, matrix, modulus, mod_inv);
+      UpdateFg(len, f, g, matrix);
+      if (g[0] == 0) {
+        int64_t rest = 0;
+        for (size_t i = 1; i < len; ++i) {
+          rest |= g[i];
+        }
+        if (rest == 0) {
+          break;
+        }
+      }
+      // Drop the top limb once both f and g fit into one limb less.
+      int64_t f_top = f[len - 1];
+      int64_t g_top = g[len - 1];
+      if (len > 1 && (f_top ^ (f_top >> 63)) == 0 &&
+          (g_top ^ (g_top >> 63)) == 0) {
+        f[len - 2] |= static_cast<int64_t>(static_cast<uint64_t>(f_top) << 62);
+        g[len - 2] |= static_cast<int64_t>(static_cast<uint64_t>(g_top) << 62);
+        --len;
+      }
+    }
+
+    // Now f = +-1, so the inverse is +-d, which lies in (-2 mod, mod).
+    if (f[len - 1] < 0) {
+      for (int64_t& limb : d) {
+        limb = -limb;
+      }
+      Carry(d);
+    }
+    while (d[kLimbs - 1] < 0) {
+      for (size_t i = 0; i < kLimbs; ++i) {
+        d[i] += modulus[i];
+      }
+      Carry(d);
+    }
+    while (!Less(d, modulus)) {
+      for (size_t i = 0; i < kLimbs; ++i) {
+        d[i] -= modulus[i];
+      }
+      Carry(d);
+    }
+    FromLimbs(d, result);
   }
 
-  [[nodiscard]] uint64_t Base() const {
-    return base_;
+ private:
+  static Limbs ToLimbs(const uint64_t* words) {
+    Limbs limbs{};
+    for (size_t i = 0; i < kLimbs; ++i) {
+      size_t word = 62 * i / 64;
+      size_t shift = 62 * i % 64;
+      uint64_t value = 0;
+      if (word < W) {
+        value = words[word] >> shift;
+        if (shift > 2 && word + 1 < W) {
+          value |= words[word + 1] << (64 - shift);
+        }
+      }
+      limbs[i] = static_cast<int64_t>(value) & kLimbMask62;
+    }
+    return limbs;
+  }
+
+  // Expects a carried value in [0, 2^(64 W)).
+  static void FromLimbs(const Limbs& limbs, uint64_t* words) {
+    std::fill(words, words + W, 0);
+    for (size_t i = 0; i < kLimbs; ++i) {
+      size_t word = 62 * i / 64;
+      size_t shift = 62 * i % 64;
+      auto limb = static_cast<uint64_t>(limbs[i]);
+      if (word < W) {
+        words[word] |= limb << shift;
+        if (shift > 2 && word + 1 < W) {
+          words[word + 1] |= limb >> (64 - shift);
+        }
+      }
+    }
   }
 
-  [[nodiscard]] uint64_t GetDigit(size_t i) const {
-    return digits_[i];
+  static void Carry(Limbs& limbs) {
+    for (size_t i = 0; i + 1 < kLimbs; ++i) {
+      limbs[i + 1] += limbs[i] >> 62;
+      limbs[i] &= kLimbMask62;
+    }
   }
 
- private:
-  void Normalize() {
-    for (size_t i = 0; i < digits_.size(); ++i) {
-      uint64_t remainder = Split(i);
-      if (remainder == 0) {
-        continue;
-      }
-      if (i + 1 == digits_.size()) {
-        digits_.push_back(remainder);
-      } else {
-        digits_[i + 1] += remainder;
+  static bool Less(const Limbs& x, const Limbs& y) {
+    for (size_t i = kLimbs; i > 0; --i) {
+      if (x[i - 1] != y[i - 1]) {
+        return x[i - 1] < y[i - 1];
       }
     }
-    while (digits_.size() > 1 && digits_.back() == 0) {
-      digits_.pop_back();
+    return false;
+  }
+
+  // Applies the matrix to (d, e) and divides by 2^62 modulo mod, adding the
+  // multiple of mod that clears the low 62 bits. Keeps both in (-2 mod, mod).
+  static void UpdateDe(Limbs& d, Limbs& e, const DivstepMatrix& matrix,
+                       const Limbs& modulus, uint64_t mod_inv) {
+    int64_t d_sign = d[kLimbs - 1] >> 63;
+    int64_t e_sign = e[kLimbs - 1] >> 63;
+    int64_t md = (matrix.u & d_sign) + (matrix.v & e_sign);
+    int64_t me = (matrix.q & d_sign) + (matrix.r & e_sign);
+    int128 cd = static_cast<int128>(matrix.u) * d[0] +
+                static_cast<int128>(matrix.v) * e[0];
+    int128 ce = static_cast<int128>(matrix.q) * d[0] +
+                static_cast<int128>(matrix.r) * e[0];
+    md -= static_cast<int64_t>((mod_inv * static_cast<uint64_t>(cd) +
+                                static_cast<uint64_t>(md)) & kLimbMask62);
+    me -= static_cast<int64_t>((mod_inv * static_cast<uint64_t>(ce) +
+                                static_cast<uint64_t>(me)) & kLimbMask62);
+    cd += static_cast<int128>(modulus[0]) * md;
+    ce += static_cast<int128>(modulus[0]) * me;
+    cd >>= 62;
+    ce >>= 62;
+    for (size_t i = 1; i < kLimbs; ++i) {
+      cd += static_cast<int128>(matrix.u) * d[i] +
+            static_cast<int128>(matrix.v) * e[i] +
+            static_cast<int128>(modulus[i]) * md;
+      ce += static_cast<int128>(matrix.q) * d[i] +
+            static_cast<int128>(matrix.r) * e[i] +
+            static_cast<int128>(modulus[i]) * me;
+      d[i - 1] = static_cast<int64_t>(cd) & kLimbMask62;
+      e[i - 1] = static_cast<int64_t>(ce) & kLimbMask62;
+      cd >>= 62;
+      ce >>= 62;
+    }
+    d[kLimbs - 1] = static_cast<int64_t>(cd);
+    e[kLimbs - 1] = static_cast<int64_t>(ce);
+  }
+
+  // Applies the matrix to the first len limbs of (f, g); the low 62 bits of
+  // the products are zero and get shifted out.
+  static void UpdateFg(size_t len, Limbs& f, Limbs& g,
+                       const DivstepMatrix& matrix) {
+    int128 cf = static_cast<int128>(matrix.u) * f[0] +
+                static_cast<int128>(matrix.v) * g[0];
+    int128 cg = static_cast<int128>(matrix.q) * f[0] +
+                static_cast<int128>(matrix.r) * g[0];
+    cf >>= 62;
+    cg >>= 62;
+    for (size_t i = 1; i < len; ++i) {
+      cf += static_cast<int128>(matrix.u) * f[i] +
+            static_cast<int128>(matrix.v) * g[i];
+      cg += static_cast<int128>(matrix.q) * f[i] +
+            static_cast<int128>(matrix.r) * g[i];
+      f[i - 1] = static_cast<int64_t>(cf) & kLimbMask62;
+      g[i - 1] = static_cast<int64_t>(cg) & kLimbMask62;
+      cf >>= 62;
+      cg >>= 62;
     }
+    f[len - 1] = static_cast<int64_t>(cf);
+    g[len - 1] = static_cast<int64_t>(cg);
   }
+};
 
-  uint64_t Split(size_t i) {
-    uint64_t remainder = digits_[i] / base_;
-    digits_[i] %= base_;
-    return remainder;
+template<unsigned N>
+intx::uint<N> InverseMod(const intx::uint<N>& a, const intx::uint<N>& mod) {
+  intx::uint<N> result;
+  SafeGcd<N / 64>::Inverse(&a[0], &mod[0], &result[0]);
+  return result;
+}
+
+// Element of the prime field described by Params, kept fully reduced in
+// Params::kWords 64-bit limbs. Params supplies the modulus and the reduction
+// of a double-width product, so each curve's field gets its own reduction at
+// compile time while the rest of the arithmetic is shared.
+template<typename Params>
+class PrimeField {
+ public:
+  static constexpr size_t kWords = Params::kWords;
+  using Uint = intx::uint<64 * kWords>;
+  static constexpr Uint kModulus = Params::kModulus;
+
+  PrimeField() = default;
+
+  // Expects value < p.
+  static constexpr PrimeField FromReduced(const Uint& value) {
+    PrimeField result;
+    result.value_ = value;
+    return result;
   }
 
-  uint64_t base_;
-  std::vector<uint64_t> digits_;
-};
+  explicit PrimeField(uint64_t value) : value_(value) {}
+
+  explicit PrimeField(const intx::u5& value)
+          : value_(Barrett().reduce(intx::uint<128 * kWords>(value))) {}
 
-Number Rebase(Number num, uint64_t new_base) {
-  Number new_number(new_base, {0});
-  for (size_t i = num.Size(); i > 0; --i) {
-    new_number *= num.Base();
-    new_number += num.GetDigit(i - 1);
+  [[nodiscard]] const Uint& Value() const {
+    return value_;
   }
-  return new_number;
-}
 
-intx::u5 BinPow(intx::u5 x, intx::u5 y, intx::u5 mod) {
-  if (y == 0) {
-    return 1;
+  [[nodiscard]] intx::u5 ToU5() const {
+    return value_;
   }
-  if (y % 2 == 0) {
-    intx::u5 half = BinPow(x, y / 2, mod);
-    return (half * half) % mod;
+
+  [[nodiscard]] bool IsZero() const {
+    return value_ == 0;
   }
-  return (x * BinPow(x, y - 1, mod)) % mod;
-}
 
-uint64_t BinPow(uint64_t x, uint64_t y, uint64_t mod) {
-  if (y == 0) {
-    return 1;
+  [[nodiscard]] bool IsOdd() const {
+    return (value_[0] & 1) != 0;
   }
-  if ((y & 1) == 0) {
-    uint64_t half = BinPow(x, y >> 1, mod);
-    return (half * half) % mod;
-  } else {
-    return (x * BinPow(x, y - 1, mod)) % mod;
+
+  friend bool operator==(const PrimeField& x, const PrimeField& y) {
+    return x.value_ == y.value_;
   }
-}
 
-uint64_t BinPow(uint64_t x, uint64_t y) {
-  if (y == 0) {
-    return 1;
+  friend bool operator!=(const PrimeField& x, const PrimeField& y) {
+    return !(x == y);
   }
-  if ((y & 1) == 0) {
-    uint64_t half = BinPow(x, y >> 1);
-    return half * half;
-  } else {
-    return x * BinPow(x, y - 1);
+
+  friend PrimeField operator+(const PrimeField& x, const PrimeField& y) {
+    PrimeField result;
+    uint64_t carry = AddLimbs(x.value_, y.value_, result.value_);
+    if (carry != 0 || result.value_ >= kModulus) {
+      SubLimbs(result.value_, kModulus, result.value_);
+    }
+    return result;
   }
-}
 
-uint64_t Mul(uint64_t a, uint64_t b, uint64_t mod) {
-  return (a * b) % mod;
-}
+  friend PrimeField operator-(const PrimeField& x, const PrimeField& y) {
+    PrimeField result;
+    if (SubLimbs(x.value_, y.value_, result.value_) != 0) {
+      AddLimbs(result.value_, kModulus, result.value_);
+    }
+    return result;
+  }
+
+  friend PrimeField operator*(const PrimeField& x, const PrimeField& y) {
+    uint64_t product[2 * kWords] = {};
+    for (size_t i = 0; i < kWords; ++i) {
+      uint64_t carry = 0;
+      for (size_t j = 0; j < kWords; ++j) {
+        uint128 current = static_cast<uint128>(x.value_[i]) * y.value_[j] +
+                          product[i + j] + carry;
+        product[i + j] = static_cast<uint64_t>(current);
+        carry = static_cast<uint64_t>(current >> 64);
+      }
+      product[i + kWords] = carry;
+    }
+    PrimeField result;
+    int64_t carry = Params::Reduce(product, result.value_);
+    while (carry < 0) {
+      carry += static_cast<int64_t>(
+              AddLimbs(result.value_, kModulus, result.value_));
+    }
+    while (carry > 0 || result.value_ >= kModulus) {
+      carry -= static_cast<int64_t>(
+              SubLimbs(result.value_, kModulus, result.value_));
+    }
+    return result;
+  }
 
-intx::u5
-Subtract(intx::u5 num1, intx::u5 num2, intx::u5 p) {
-  if (num1 >= num2) {
-    return (num1 - num2) % p;
+  [[nodiscard]] PrimeField Square() const {
+    return *this * *this;
   }
-  return (num1 + p) - num2;
-}
 
-class CurvePoint {
+  [[nodiscard]] PrimeField Pow(const Uint& exponent) const {
+    PrimeField result(1);
+    for (size_t i = 64 * kWords; i > 0; --i) {
+      result = result.Square();
+      if (((exponent[(i - 1) / 64] >> ((i - 1) % 64)) & 1) != 0) {
+        result = result * *this;
+      }
+    }
+    return result;
+  }
+
+  // Returns 0 for zero.
+  [[nodiscard]] PrimeField Inverse() const {
+    PrimeField result;
+    result.value_ = InverseMod(value_, kModulus);
+    return result;
+  }
+
+ private:
+  static uint64_t AddLimbs(const Uint& x, const Uint& y, Uint& result) {
+    uint64_t carry = 0;
+    for (size_t i = 0; i < kWords; ++i) {
+      uint128 sum = static_cast<uint128>(x[i]) + y[i] + carry;
+      result[i] = static_cast<uint64_t>(sum);
+      carry = static_cast<uint64_t>(sum >> 64);
+    }
+    return carry;
+  }
+
+  static uint64_t SubLimbs(const Uint& x, const Uint& y, Uint& result) {
+    uint64_t borrow = 0;
+    for (size_t i = 0; i < kWords; ++i) {
+      uint128 difference = static_cast<uint128>(x[i]) - y[i] - borrow;
+      result[i] = static_cast<uint64_t>(difference);
+      borrow = static_cast<uint64_t>(difference >> 64) & 1;
+    }
+    return borrow;
+  }
+
+  // Reduces parsed numbers without a long division.
+  static const intx::barrett_context<64 * kWords>& Barrett() {
+    static const intx::barrett_context<64 * kWords> context(kModulus);
+    return context;
+  }
+
+  Uint value_;
+};
+
+// Field parameters. Reduce(product, result) stores in result a value that,
+// with the returned signed carry above its top word, is congruent to the
+// double-width product. PrimeField then brings it below p.
+
+// p = 2^256 - 2^224 + 2^192 + 2^96 - 1 is a generalized Mersenne prime, so
+// products are reduced with the Solinas identities (FIPS 186-4, D.2.3)
+// instead of a division.
+struct P256FieldParams {
+  static constexpr size_t kWords = 4;
+  static constexpr intx::uint256 kModulus{0xffffffffffffffff,
+                                          0x00000000ffffffff, 0,
+                                          0xffffffff00000001};
+
+  // Splits the product into 32-bit words c0..c15 and sums
+  // s1 + 2 s2 + 2 s3 + s4 + s5 - s6 - s7 - s8 - s9.
+  static int64_t Reduce(const uint64_t (&product)[8], intx::uint256& result) {
+    int64_t c[16];
+    for (size_t i = 0; i < 8; ++i) {
+      c[2 * i] = static_cast<int64_t>(product[i] & 0xffffffff);
+      c[2 * i + 1] = static_cast<int64_t>(product[i] >> 32);
+    }
+    int64_t words[8] = {
+            c[0] + c[8] + c[9] - c[11] - c[12] - c[13] - c[14],
+            c[1] + c[9] + c[10] - c[12] - c[13] - c[14] - c[15],
+            c[2] + c[10] + c[11] - c[13] - c[14] - c[15],
+            c[3] + 2 * c[11] + 2 * c[12] + c[13] - c[15] - c[8] - c[9],
+            c[4] + 2 * c[12] + 2 * c[13] + c[14] - c[9] - c[10],
+            c[5] + 2 * c[13] + 2 * c[14] + c[15] - c[10] - c[11],
+            c[6] + 3 * c[14] + 2 * c[15] + c[13] - c[8] - c[9],
+            c[7] + 3 * c[15] + c[8] - c[10] - c[11] - c[12] - c[13],
+    };
+    result = 0;
+    int64_t carry = 0;
+    for (size_t i = 0; i < 8; ++i) {
+      carry += words[i];
+      uint64_t word = static_cast<uint64_t>(carry) & 0xffffffff;
+      result[i / 2] |= word << (32 * (i % 2));
+      carry >>= 32;
+    }
+    return carry;
+  }
+};
+
+using P256Field = PrimeField<P256FieldParams>;
+
+// Curve registry: y^2 = x^3 + a x + b over Field, with generator (kGx, kGy)
+// of order kGroupSize. Points refer to these parameters instead of carrying
+// their own copies, and kAForm lets doubling drop the multiplication by a at
+// compile time.
+enum class CoefficientA {
+  kMinusThree,
+  kOther,
+};
+
+// NIST P-256.
+struct P256 {
+  using Field = P256Field;
+  using Scalar = intx::uint256;
+  static constexpr CoefficientA kAForm = CoefficientA::kMinusThree;
+  static constexpr Field kA = Field::FromReduced(Field::kModulus - 3);
+  static constexpr Field kB = Field::FromReduced(
+          41058363725152142129326129780047268409114441015993725554835256314039467401291_u256);
+  static constexpr Field kGx = Field::FromReduced(
+          48439561293906451759052585252797914202762949526041747995844080717082404635286_u256);
+  static constexpr Field kGy = Field::FromReduced(
+          36134250956749795798585127919587881956611106672985015071877198253568414405109_u256);
+  static constexpr Scalar kGroupSize =
+          115792089210356248762697446949407573529996955224135760342422259061068512044369_u256;
+};
+
+template<typename Curve>
+class BasicCurvePoint {
  public:
-  CurvePoint(intx::u5 a, intx::u5 b, intx::u5 p)
-          : inf_(true),
-            x_(0),
-            y_(0),
-            a_(a),
-            b_(b),
-            p_(p) {}
-
-  CurvePoint(intx::u5 x, intx::u5 y, intx::u5 a, intx::u5 b,
-             intx::u5 p)
+  using Field = typename Curve::Field;
+
+  BasicCurvePoint() : inf_(true) {}
+
+  BasicCurvePoint(Field x, Field y)
           : inf_(false),
             x_(x),
-            y_(y),
-            a_(a),
-            b_(b),
-            p_(p) {}
+            y_(y) {}
 
   [[nodiscard]] bool IsInf() const {
     return inf_;
   }
 
-  [[nodiscard]] intx::u5 GetX() const {
+  [[nodiscard]] Field GetX() const {
     return x_;
   }
 
-  [[nodiscard]] intx::u5 GetY() const {
+  [[nodiscard]] Field GetY() const {
     return y_;
   }
 
-  [[nodiscard]] intx::u5 GetA() const {
-    return a_;
+ private:
+  bool inf_;
+  Field x_;
+  Field y_;
+};
+
+// Point in Jacobian coordinates (X : Y : Z), which stands for the affine point
+// (X / Z^2, Y / Z^3). Z = 0 is the point at infinity. Group operations need
+// no inversions, so points stay in this form until they are printed.
+template<typename Curve>
+class BasicJacobianPoint {
+ public:
+  using Field = typename Curve::Field;
+
+  BasicJacobianPoint() : x_(0), y_(1), z_(0) {}
+
+  BasicJacobianPoint(Field x, Field y, Field z)
+          : x_(x),
+            y_(y),
+            z_(z) {}
+
+  explicit BasicJacobianPoint(const BasicCurvePoint<Curve>& point)
+          : x_(point.GetX()),
+            y_(point.GetY()),
+            z_(point.IsInf() ? 0 : 1) {}
+
+  [[nodiscard]] bool IsInf() const {
+    return z_.IsZero();
+  }
+
+  [[nodiscard]] Field GetX() const {
+    return x_;
   }
 
-  [[nodiscard]] intx::u5 GetB() const {
-    return b_;
+  [[nodiscard]] Field GetY() const {
+    return y_;
   }
 
-  [[nodiscard]] intx::u5 GetP() const {
-    return p_;
+  [[nodiscard]] Field GetZ() const {
+    return z_;
   }
 
  private:
-  bool inf_;
-  intx::u5 x_;
-  intx::u5 y_;
-  intx::u5 a_;
-  intx::u5 b_;
-  intx::u5 p_;
+  Field x_;
+  Field y_;
+  Field z_;
 };
 
-CurvePoint operator*(const CurvePoint& p1, const CurvePoint& p2) {
+// The encryptor works on P-256.
+using CurvePoint = BasicCurvePoint<P256>;
+using JacobianPoint = BasicJacobianPoint<P256>;
+
+// dbl-2007-bl.
+template<typename Curve>
+BasicJacobianPoint<Curve> Double(const BasicJacobianPoint<Curve>& point) {
+  using Field = typename Curve::Field;
+  if (point.IsInf()) {
+    return point;
+  }
+  Field xx = point.GetX().Square();
+  Field yy = point.GetY().Square();
+  Field yyyy = yy.Square();
+  Field zz = point.GetZ().Square();
+  Field s = (point.GetX() + yy).Square() - xx - yyyy;
+  s = s + s;
+  // m = 3 xx + a zz^2.
+  Field m;
+  if constexpr (Curve::kAForm == CoefficientA::kMinusThree) {
+    m = (point.GetX() - zz) * (point.GetX() + zz);
+    m = m + m + m;
+  } else {
+    m = xx + xx + xx + Curve::kA * zz.Square();
+  }
+  Field x = m.Square() - (s + s);
+  Field yyyy_8 = yyyy + yyyy;
+  yyyy_8 = yyyy_8 + yyyy_8;
+  yyyy_8 = yyyy_8 + yyyy_8;
+  Field y = m * (s - x) - yyyy_8;
+  Field z = (point.GetY() + point.GetZ()).Square() - yy - zz;
+  return {x, y, z};
+}
+
+// add-2007-bl.
+template<typename Curve>
+BasicJacobianPoint<Curve> operator*(const BasicJacobianPoint<Curve>& p1,
+                                    const BasicJacobianPoint<Curve>& p2) {
+  using Field = typename Curve::Field;
   if (p1.IsInf()) {
     return p2;
   }
   if (p2.IsInf()) {
     return p1;
   }
-  if (p1.GetX() != p2.GetX()) {
-    intx::u5 p = p1.GetP();
-    intx::u5 y2_y1 = Subtract(p2.GetY(), p1.GetY(), p);
-    intx::u5 x2_x1 = Subtract(p2.GetX(), p1.GetX(), p);
-    intx::u5 x2_x1_inv = BinPow(x2_x1, p - 2, p);
-    intx::u5 k = (y2_y1 * x2_x1_inv) % p;
-    intx::u5 x = Subtract(k * k, (p1.GetX() + p2.GetX()) % p, p);
-    intx::u5 y = Subtract(k * Subtract(p1.GetX(), x, p), p1.GetY(), p);
-    return {x, y, p1.GetA(), p1.GetB(), p};
-  } else if (p1.GetY() != p2.GetY()) {
-    return {p1.GetA(), p1.GetB(), p1.GetP()};
-  }
-  intx::u5 p = p1.GetP();
-  intx::u5 x1_2 = (p1.GetX() * p1.GetX()) % p;
-  intx::u5 x1_2_3 = (x1_2 * 3) % p;
-  intx::u5 x1_2_3_a = (x1_2_3 + p1.GetA()) % p;
-  intx::u5 y1_2 = (2 * p1.GetY()) % p;
-  intx::u5 y1_2_inv = BinPow(y1_2, p - 2, p);
-  intx::u5 k = (x1_2_3_a * y1_2_inv) % p;
-  intx::u5 x = Subtract(k * k, (2 * p1.GetX()) % p, p);
-  intx::u5 y = Subtract(k * Subtract(p1.GetX(), x, p), p1.GetY(), p);
-  return {x, y, p1.GetA(), p1.GetB(), p};
+  Field z1_z1 = p1.GetZ().Square();
+  Field z2_z2 = p2.GetZ().Square();
+  Field u1 = p1.GetX() * z2_z2;
+  Field u2 = p2.GetX() * z1_z1;
+  Field s1 = p1.GetY() * p2.GetZ() * z2_z2;
+  Field s2 = p2.GetY() * p1.GetZ() * z1_z1;
+  Field h = u2 - u1;
+  Field r = s2 - s1;
+  if (h.IsZero()) {
+    if (r.IsZero()) {
+      return Double(p1);
+    }
+    return {};
+  }
+  r = r + r;
+  Field i = (h + h).Square();
+  Field j = h * i;
+  Field v = u1 * i;
+  Field x = r.Square() - j - (v + v);
+  Field s1_j = s1 * j;
+  Field y = r * (v - x) - (s1_j + s1_j);
+  Field z = ((p1.GetZ() + p2.GetZ()).Square() - z1_z1 - z2_z2) * h;
+  return {x, y, z};
+}
+
+// madd-2007-bl, the second point is affine.
+template<typename Curve>
+BasicJacobianPoint<Curve> operator*(const BasicJacobianPoint<Curve>& p1,
+                                    const BasicCurvePoint<Curve>& p2) {
+  using Field = typename Curve::Field;
+  if (p1.IsInf()) {
+    return BasicJacobianPoint<Curve>(p2);
+  }
+  if (p2.IsInf()) {
+    return p1;
+  }
+  Field z1_z1 = p1.GetZ().Square();
+  Field u2 = p2.GetX() * z1_z1;
+  Field s2 = p2.GetY() * p1.GetZ() * z1_z1;
+  Field h = u2 - p1.GetX();
+  Field r = s2 - p1.GetY();
+  if (h.IsZero()) {
+    if (r.IsZero()) {
+      return Double(p1);
+    }
+    return {};
+  }
+  r = r + r;
+  Field hh = h.Square();
+  Field i = hh + hh;
+  i = i + i;
+  Field j = h * i;
+  Field v = p1.GetX() * i;
+  Field x = r.Square() - j - (v + v);
+  Field y1_j = p1.GetY() * j;
+  Field y = r * (v - x) - (y1_j + y1_j);
+  Field z = (p1.GetZ() + h).Square() - z1_z1 - hh;
+  return {x, y, z};
+}
+
+// Replaces every value by its inverse using Montgomery's trick: one inversion
+// and three multiplications per element. Zeros are left as they are.
+template<typename Field>
+void InvertBatch(std::vector<Field>& values) {
+  std::vector<Field> prefix(values.size() + 1);
+  prefix[0] = Field(1);
+  for (size_t i = 0; i < values.size(); ++i) {
+    prefix[i + 1] = values[i].IsZero() ? prefix[i] : prefix[i] * values[i];
+  }
+  Field inv = prefix.back().Inverse();
+  for (size_t i = values.size(); i > 0; --i) {
+    if (values[i - 1].IsZero()) {
+      continue;
+    }
+    Field value = values[i - 1];
+    values[i - 1] = inv * prefix[i - 1];
+    inv = inv * value;
+  }
+}
+
+template<typename Curve>
+BasicCurvePoint<Curve> ToAffine(const BasicJacobianPoint<Curve>& point,
+                                const typename Curve::Field& z_inv) {
+  if (point.IsInf()) {
+    return {};
+  }
+  typename Curve::Field z_inv_2 = z_inv.Square();
+  return {point.GetX() * z_inv_2, point.GetY() * z_inv_2 * z_inv};
+}
+
+template<typename Curve>
+BasicCurvePoint<Curve> ToAffine(const BasicJacobianPoint<Curve>& point) {
+  return ToAffine(point, point.GetZ().Inverse());
+}
+
+// Normalizes all points with a single field inversion.
+template<typename Curve>
+std::vector<BasicCurvePoint<Curve>>
+ToAffine(const std::vector<BasicJacobianPoint<Curve>>& points) {
+  std::vector<typename Curve::Field> z_inv;
+  z_inv.reserve(points.size());
+  for (const BasicJacobianPoint<Curve>& point : points) {
+    z_inv.push_back(point.GetZ());
+  }
+  InvertBatch(z_inv);
+  std::vector<BasicCurvePoint<Curve>> result;
+  result.reserve(points.size());
+  for (size_t i = 0; i < points.size(); ++i) {
+    result.push_back(ToAffine(points[i], z_inv[i]));
+  }
+  return result;
+}
+
+template<typename Curve>
+BasicCurvePoint<Curve> operator*(const BasicCurvePoint<Curve>& p1,
+                                 const BasicCurvePoint<Curve>& p2) {
+  return ToAffine(BasicJacobianPoint<Curve>(p1) * p2);
+}
+
+// Recovers the point from x and the parity of y. p = 3 (mod 4), so the square
+// root is a single exponentiation to (p + 1) / 4.
+template<typename Curve>
+BasicCurvePoint<Curve> Decompress(const typename Curve::Field& x, bool odd_y) {
+  using Field = typename Curve::Field;
+  static_assert(Field::kModulus[0] % 4 == 3);
+  Field y_2 = x.Square() * x + Curve::kA * x + Curve::kB;
+  Field y = y_2.Pow((Field::kModulus + 1) / 4);
+  if (y.Square() != y_2) {
+    throw std::runtime_error("Compressed point is not on the curve");
+  }
+  if (y.IsOdd() != odd_y) {
+    y = Field(0) - y;
+  }
+  return {x, y};
+}
+
+template<typename Curve>
+BasicJacobianPoint<Curve> Negate(const BasicJacobianPoint<Curve>& point) {
+  return {point.GetX(), typename Curve::Field(0) - point.GetY(),
+          point.GetZ()};
+}
+
+const int kWnafWidth = 5;
+
+// Width-w non-adjacent form of k, least significant digit first. Non-zero
+// digits are odd, lie in (-2^(w-1), 2^(w-1)), and any w consecutive digits
+// contain at most one of them.
+template<unsigned N>
+std::vector<int> ToWnaf(const intx::uint<N>& k, int width) {
+  std::vector<int> digits;
+  digits.reserve(N + 1);
+  intx::uint<N + 64> rest = k;
+  const uint64_t mask = (uint64_t{1} << width) - 1;
+  while (rest != 0) {
+    int digit = 0;
+    if ((rest[0] & 1) != 0) {
+      digit = static_cast<int>(rest[0] & mask);
+      if (digit >= (1 << (width - 1))) {
+        digit -= 1 << width;
+        rest += static_cast<uint64_t>(-digit);
+      } else {
+        rest -= static_cast<uint64_t>(digit);
+      }
+    }
+    digits.push_back(digit);
+    rest >>= 1;
+  }
+  return digits;
+}
+
+// Computes k * point with a left-to-right wNAF ladder over the precomputed
+// odd multiples point, 3 point, ..., (2^(w-1) - 1) point.
+template<typename Curve>
+BasicJacobianPoint<Curve> Mul(const BasicCurvePoint<Curve>& point,
+                              const typename Curve::Scalar& k,
+                              int width = kWnafWidth) {
+  BasicJacobianPoint<Curve> result;
+  if (point.IsInf() || k == 0) {
+    return result;
+  }
+  std::vector<BasicJacobianPoint<Curve>> odd_multiples;
+  odd_multiples.reserve(size_t{1} << (width - 2));
+  odd_multiples.emplace_back(point);
+  BasicJacobianPoint<Curve> twice = Double(odd_multiples[0]);
+  for (size_t i = 1; i < (size_t{1} << (width - 2)); ++i) {
+    odd_multiples.push_back(odd_multiples.back() * twice);
+  }
+  std::vector<int> digits = ToWnaf(k, width);
+  for (size_t i = digits.size(); i > 0; --i) {
+    result = Double(result);
+    int digit = digits[i - 1];
+    if (digit > 0) {
+      result = result * odd_multiples[digit / 2];
+    } else if (digit < 0) {
+      result = result * Negate(odd_multiples[-digit / 2]);
+    }
+  }
+  return result;
 }
 
+// Radix-2^52 Montgomery arithmetic on kLanes independent P-256 field elements
+// at once. Limb i of all lanes is contiguous, so it fills one AVX-512 register
+// or two AVX2 ones. Values are fully reduced and in Montgomery form with
+// R = 2^260.
+constexpr size_t kLanes = 8;
+constexpr size_t kLimbs52 = 5;
+constexpr uint64_t kLimbMask52 = (uint64_t{1} << 52) - 1;
+constexpr uint32_t kAllLanes = (uint32_t{1} << kLanes) - 1;
+
+using Limbs52 = std::array<uint64_t, kLimbs52>;
+
+struct FieldLanes {
+  alignas(64) uint64_t limbs[kLimbs52][kLanes];
+};
+
+struct PointLanes {
+  FieldLanes x;
+  FieldLanes y;
+  FieldLanes z;
+};
+
+Limbs52 ToLimbs52(const intx::uint256& x) {
+  Limbs52 limbs{};
+  for (size_t i = 0; i < kLimbs52; ++i) {
+    limbs[i] = static_cast<uint64_t>(x >> (52 * i)) & kLimbMask52;
+  }
+  return limbs;
+}
+
+intx::uint256 FromLimbs52(const Limbs52& limbs) {
+  intx::uint256 x = 0;
+  for (size_t i = kLimbs52; i > 0; --i) {
+    x = (x << 52) | limbs[i - 1];
+  }
+  return x;
+}
+
+struct Montgomery52 {
+  Limbs52 modulus;
+  // -p^-1 mod 2^52.
+  uint64_t mod_inv;
+  // R^2 mod p, multiplying by it converts to Montgomery form.
+  Limbs52 r2;
+  // R mod p, the Montgomery form of 1.
+  Limbs52 one;
+  // p in radix 2^26 and -p^-1 mod 2^26, for kernels with 32-bit multipliers.
+  std::array<uint64_t, 2 * kLimbs52> modulus26;
+  uint64_t mod_inv26;
+};
+
+const Montgomery52& P256Montgomery52() {
+  static const Montgomery52 constants = [] {
+    Montgomery52 result{};
+    result.modulus = ToLimbs52(P256Field::kModulus);
+    uint64_t inv = P256Field::kModulus[0];
+    for (size_t i = 0; i < 5; ++i) {
+      inv *= 2 - P256Field::kModulus[0] * inv;
+    }
+    result.mod_inv = (0 - inv) & kLimbMask52;
+    P256Field power(1);
+    for (size_t i = 1; i <= 2 * 52 * kLimbs52; ++i) {
+      power = power + power;
+      if (i == 52 * kLimbs52) {
+        result.one = ToLimbs52(power.Value());
+      }
+    }
+    result.r2 = ToLimbs52(power.Value());
+    for (size_t i = 0; i < 2 * kLimbs52; ++i) {
+      result.modulus26[i] = static_cast<uint64_t>(
+              P256Field::kModulus >> (26 * i)) & ((uint64_t{1} << 26) - 1);
+    }
+    result.mod_inv26 = result.mod_inv & ((uint64_t{1} << 26) - 1);
+    return result;
+  }();
+  return constants;
+}
+
+// Subtracts p if x >= p, x must be below 2p.
+Limbs52 ReduceOnce52(const Limbs52& x) {
+  const Limbs52& modulus = P256Montgomery52().modulus;
+  Limbs52 difference{};
+  int64_t carry = 0;
+  for (size_t i = 0; i < kLimbs52; ++i) {
+    carry += static_cast<int64_t>(x[i]) - static_cast<int64_t>(modulus[i]);
+    difference[i] = static_cast<uint64_t>(carry) & kLimbMask52;
+    carry >>= 52;
+  }
+  return carry < 0 ? x : difference;
+}
+
+Limbs52 MontMul52(const Limbs52& a, const Limbs52& b) {
+  const Montgomery52& constants = P256Montgomery52();
+  uint128 t[2 * kLimbs52] = {};
+  for (size_t i = 0; i < kLimbs52; ++i) {
+    for (size_t j = 0; j < kLimbs52; ++j) {
+      t[i + j] += static_cast<uint128>(a[i]) * b[j];
+    }
+  }
+  for (size_t i = 0; i < kLimbs52; ++i) {
+    uint64_t q = (static_cast<uint64_t>(t[i]) * constants.mod_inv) &
+                 kLimbMask52;
+    for (size_t j = 0; j < kLimbs52; ++j) {
+      t[i + j] += static_cast<uint128>(q) * constants.modulus[j];
+    }
+    t[i + 1] += t[i] >> 52;
+  }
+  Limbs52 result{};
+  uint128 carry = 0;
+  for (size_t i = 0; i < kLimbs52; ++i) {
+    carry += t[kLimbs52 + i];
+    result[i] = static_cast<uint64_t>(carry) & kLimbMask52;
+    carry >>= 52;
+  }
+  return ReduceOnce52(result);
+}
+
+Limbs52 ToMontgomery52(const P256Field& x) {
+  return MontMul52(ToLimbs52(x.Value()), P256Montgomery52().r2);
+}
+
+P256Field FromMontgomery52(const Limbs52& x) {
+  return P256Field::FromReduced(FromLimbs52(MontMul52(x, {1, 0, 0, 0, 0})));
+}
+
+Limbs52 GetLane(const FieldLanes& x, size_t lane) {
+  Limbs52 limbs{};
+  for (size_t i = 0; i < kLimbs52; ++i) {
+    limbs[i] = x.limbs[i][lane];
+  }
+  return limbs;
+}
+
+void SetLane(FieldLanes& x, size_t lane, const Limbs52& limbs) {
+  for (size_t i = 0; i < kLimbs52; ++i) {
+    x.limbs[i][lane] = limbs[i];
+  }
+}
+
+// Copies the lanes of x selected by mask into result.
+void Select(uint32_t mask, const FieldLanes& x, FieldLanes& result) {
+  for (size_t i = 0; i < kLimbs52; ++i) {
+    for (size_t lane = 0; lane < kLanes; ++lane) {
+      if (((mask >> lane) & 1) != 0) {
+        result.limbs[i][lane] = x.limbs[i][lane];
+      }
+    }
+  }
+}
+
+// Lane kernels: each provides Mul, Add, Sub and IsZero over all kLanes lanes.
+// MulBaseBatch picks the fastest one the CPU supports at run time.
+
+// Lane by lane with the scalar radix-2^52 code.
+struct PortableLanes {
+  static void Mul(const FieldLanes& a, const FieldLanes& b,
+                  FieldLanes& result) {
+    for (size_t lane = 0; lane < kLanes; ++lane) {
+      SetLane(result, lane, MontMul52(GetLane(a, lane), GetLane(b, lane)));
+    }
+  }
+
+  static void Add(const FieldLanes& a, const FieldLanes& b,
+                  FieldLanes& result) {
+    for (size_t lane = 0; lane < kLanes; ++lane) {
+      Limbs52 sum{};
+      uint64_t carry = 0;
+      for (size_t i = 0; i < kLimbs52; ++i) {
+        carry += a.limbs[i][lane] + b.limbs[i][lane];
+        sum[i] = carry & kLimbMask52;
+        carry >>= 52;
+      }
+      SetLane(result, lane, ReduceOnce52(sum));
+    }
+  }
+
+  static void Sub(const FieldLanes& a, const FieldLanes& b,
+                  FieldLanes& result) {
+    const Limbs52& modulus = P256Montgomery52().modulus;
+    for (size_t lane = 0; lane < kLanes; ++lane) {
+      Limbs52 difference{};
+      int64_t carry = 0;
+      for (size_t i = 0; i < kLimbs52; ++i) {
+        carry += static_cast<int64_t>(a.limbs[i][lane]) -
+                 static_cast<int64_t>(b.limbs[i][lane]);
+        difference[i] = static_cast<uint64_t>(carry) & kLimbMask52;
+        carry >>= 52;
+      }
+      if (carry < 0) {
+        uint64_t sum_carry = 0;
+        for (size_t i = 0; i < kLimbs52; ++i) {
+          sum_carry += difference[i] + modulus[i];
+          difference[i] = sum_carry & kLimbMask52;
+          sum_carry >>= 52;
+        }
+      }
+      SetLane(result, lane, difference);
+    }
+  }
+
+  static uint32_t IsZero(const FieldLanes& x) {
+    uint32_t mask = 0;
+    for (size_t lane = 0; lane < kLanes; ++lane) {
+      uint64_t bits = 0;
+      for (size_t i = 0; i < kLimbs52; ++i) {
+        bits |= x.limbs[i][lane];
+      }
+      mask |= static_cast<uint32_t>(bits == 0) << lane;
+    }
+    return mask;
+  }
+};
+
+#if HAS_X86_SIMD
+
+// AVX2 has no 52-bit multiplier, so Mul splits every limb in two and works in
+// radix 2^26 with 32 x 32-bit multiplies. Ten such limbs span the same 260
+// bits, so R and the Montgomery form do not change. A product of two limbs
+// fits in a 64-bit accumulator with room for the sums, so no high halves are
+// needed. Registers hold 4 lanes, every step runs on both halves of a
+// FieldLanes.
+struct Avx2Lanes {
+  static constexpr size_t kHalf = 4;
+
+  [[gnu::target("avx2")]] static void Mul(const FieldLanes& a,
+                                          const FieldLanes& b,
+                                          FieldLanes& result) {
+    const Montgomery52& constants = P256Montgomery52();
+    const __m256i mask = _mm256_set1_epi64x(kLimbMask26);
+    const __m256i mod_inv = _mm256_set1_epi64x(constants.mod_inv26);
+    for (size_t half = 0; half < kLanes; half += kHalf) {
+      __m256i av[kLimbs26];
+      __m256i bv[kLimbs26];
+      for (size_t i = 0; i < kLimbs52; ++i) {
+        __m256i x = Load(a, i, half);
+        __m256i y = Load(b, i, half);
+        av[2 * i] = _mm256_and_si256(x, mask);
+        av[2 * i + 1] = _mm256_srli_epi64(x, 26);
+        bv[2 * i] = _mm256_and_si256(y, mask);
+        bv[2 * i + 1] = _mm256_srli_epi64(y, 26);
+      }
+      __m256i t[2 * kLimbs26];
+      for (__m256i& limb : t) {
+        limb = _mm256_setzero_si256();
+      }
+      for (size_t i = 0; i < kLimbs26; ++i) {
+        for (size_t j = 0; j < kLimbs26; ++j) {
+          t[i + j] = _mm256_add_epi64(t[i + j],
+                                      _mm256_mul_epu32(av[i], bv[j]));
+        }
+      }
+      for (size_t i = 0; i < kLimbs26; ++i) {
+        __m256i q = _mm256_and_si256(_mm256_mul_epu32(t[i], mod_inv), mask);
+        for (size_t j = 0; j < kLimbs26; ++j) {
+          t[i + j] = _mm256_add_epi64(t[i + j], _mm256_mul_epu32(
+                  q, _mm256_set1_epi64x(constants.modulus26[j])));
+        }
+        t[i + 1] = _mm256_add_epi64(t[i + 1], _mm256_srli_epi64(t[i], 26));
+      }
+      __m256i r[kLimbs52];
+      __m256i carry = _mm256_setzero_si256();
+      for (size_t i = 0; i < kLimbs52; ++i) {
+        carry = _mm256_add_epi64(carry, t[kLimbs26 + 2 * i]);
+        __m256i low = _mm256_and_si256(carry, mask);
+        carry = _mm256_add_epi64(_mm256_srli_epi64(carry, 26),
+                                 t[kLimbs26 + 2 * i + 1]);
+        r[i] = _mm256_or_si256(
+                low, _mm256_slli_epi64(_mm256_and_si256(carry, mask), 26));
+        carry = _mm256_srli_epi64(carry, 26);
+      }
+      ReduceOnce(r);
+      Store(r, half, result);
+    }
+  }
+
+  [[gnu::target("avx2")]] static void Add(const FieldLanes& a,
+                                          const FieldLanes& b,
+                                          FieldLanes& result) {
+    const __m256i mask = _mm256_set1_epi64x(kLimbMask52);
+    for (size_t half = 0; half < kLanes; half += kHalf) {
+      __m256i sum[kLimbs52];
+      __m256i carry = _mm256_setzero_si256();
+      for (size_t i = 0; i < kLimbs52; ++i) {
+        carry = _mm256_add_epi64(
+                carry, _mm256_add_epi64(Load(a, i, half), Load(b, i, half)));
+        sum[i] = _mm256_and_si256(carry, mask);
+        carry = _mm256_srli_epi64(carry, 52);
+      }
+      ReduceOnce(sum);
+      Store(sum, half, result);
+    }
+  }
+
+  [[gnu::target("avx2")]] static void Sub(const FieldLanes& a,
+                                          const FieldLanes& b,
+                                          FieldLanes& result) {
+    const Montgomery52& constants = P256Montgomery52();
+    const __m256i mask = _mm256_set1_epi64x(kLimbMask52);
+    for (size_t half = 0; half < kLanes; half += kHalf) {
+      __m256i difference[kLimbs52];
+      __m256i borrow = _mm256_setzero_si256();
+      for (size_t i = 0; i < kLimbs52; ++i) {
+        __m256i limb = _mm256_add_epi64(
+                borrow, _mm256_sub_epi64(Load(a, i, half), Load(b, i, half)));
+        difference[i] = _mm256_and_si256(limb, mask);
+        borrow = Negative(limb);
+      }
+      __m256i carry = _mm256_setzero_si256();
+      for (size_t i = 0; i < kLimbs52; ++i) {
+        carry = _mm256_add_epi64(
+                carry, _mm256_add_epi64(difference[i], _mm256_and_si256(
+                        borrow, _mm256_set1_epi64x(constants.modulus[i]))));
+        difference[i] = _mm256_and_si256(carry, mask);
+        carry = _mm256_srli_epi64(carry, 52);
+      }
+      Store(difference, half, result);
+    }
+  }
+
+  [[gnu::target("avx2")]] static uint32_t IsZero(const FieldLanes& x) {
+    uint32_t mask = 0;
+    for (size_t half = 0; half < kLanes; half += kHalf) {
+      __m256i bits = _mm256_setzero_si256();
+      for (size_t i = 0; i < kLimbs52; ++i) {
+        bits = _mm256_or_si256(bits, Load(x, i, half));
+      }
+      __m256i zero = _mm256_cmpeq_epi64(bits, _mm256_setzero_si256());
+      mask |= static_cast<uint32_t>(
+              _mm256_movemask_pd(_mm256_castsi256_pd(zero))) << half;
+    }
+    return mask;
+  }
+
+ private:
+  static constexpr size_t kLimbs26 = 2 * kLimbs52;
+  static constexpr uint64_t kLimbMask26 = (uint64_t{1} << 26) - 1;
+
+  [[gnu::target("avx2")]] static __m256i Load(const FieldLanes& x, size_t i,
+                                              size_t half) {
+    return _mm256_load_si256(
+            reinterpret_cast<const __m256i*>(&x.limbs[i][half]));
+  }
+
+  [[gnu::target("avx2")]] static void Store(const __m256i (&v)[kLimbs52],
+                                            size_t half, FieldLanes& x) {
+    for (size_t i = 0; i < kLimbs52; ++i) {
+      _mm256_store_si256(reinterpret_cast<__m256i*>(&x.limbs[i][half]), v[i]);
+    }
+  }
+
+  // All ones in the lanes where the signed limb is negative. AVX2 has no
+  // 64-bit arithmetic shift; limbs here are above -2^63 / 2^52 anyway, so
+  // the borrow into the next limb is -1 or 0.
+  [[gnu::target("avx2")]] static __m256i Negative(__m256i x) {
+    return _mm256_cmpgt_epi64(_mm256_setzero_si256(), x);
+  }
+
+  // Subtracts p in the lanes where x >= p, x must be below 2p.
+  [[gnu::target("avx2")]] static void ReduceOnce(__m256i (&x)[kLimbs52]) {
+    const Montgomery52& constants = P256Montgomery52();
+    const __m256i mask = _mm256_set1_epi64x(kLimbMask52);
+    __m256i difference[kLimbs52];
+    __m256i borrow = _mm256_setzero_si256();
+    for (size_t i = 0; i < kLimbs52; ++i) {
+      __m256i limb = _mm256_add_epi64(borrow, _mm256_sub_epi64(
+              x[i], _mm256_set1_epi64x(constants.modulus[i])));
+      difference[i] = _mm256_and_si256(limb, mask);
+      borrow = Negative(limb);
+    }
+    for (size_t i = 0; i < kLimbs52; ++i) {
+      x[i] = _mm256_blendv_epi8(difference[i], x[i], borrow);
+    }
+  }
+};
+
+// AVX-512 IFMA: a register holds limb i of all 8 lanes and every step is a
+// 52-bit multiply-accumulate.
+// GCC 12 warns about its own _mm512_undefined_epi32 in the shift intrinsics.
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+struct Avx512IfmaLanes {
+  [[gnu::target("avx512f,avx512ifma")]] static void Mul(const FieldLanes& a,
+                                                        const FieldLanes& b,
+                                                        FieldLanes& result) {
+    const Montgomery52& constants = P256Montgomery52();
+    __m512i av[kLimbs52];
+    __m512i bv[kLimbs52];
+    Load(a, av);
+    Load(b, bv);
+    __m512i t[2 * kLimbs52];
+    for (__m512i& limb : t) {
+      limb = _mm512_setzero_si512();
+    }
+    for (size_t i = 0; i < kLimbs52; ++i) {
+      for (size_t j = 0; j < kLimbs52; ++j) {
+        t[i + j] = _mm512_madd52lo_epu64(t[i + j], av[i], bv[j]);
+        t[i + j + 1] = _mm512_madd52hi_epu64(t[i + j + 1], av[i], bv[j]);
+      }
+    }
+    const __m512i mod_inv = _mm512_set1_epi64(constants.mod_inv);
+    for (size_t i = 0; i < kLimbs52; ++i) {
+      __m512i q = _mm512_madd52lo_epu64(_mm512_setzero_si512(), t[i],
+                                        mod_inv);
+      for (size_t j = 0; j < kLimbs52; ++j) {
+        __m512i modulus = _mm512_set1_epi64(constants.modulus[j]);
+        t[i + j] = _mm512_madd52lo_epu64(t[i + j], q, modulus);
+        t[i + j + 1] = _mm512_madd52hi_epu64(t[i + j + 1], q, modulus);
+      }
+      t[i + 1] = _mm512_add_epi64(t[i + 1], _mm512_srli_epi64(t[i], 52));
+    }
+    const __m512i mask = _mm512_set1_epi64(kLimbMask52);
+    __m512i r[kLimbs52];
+    __m512i carry = _mm512_setzero_si512();
+    for (size_t i = 0; i < kLimbs52; ++i) {
+      carry = _mm512_add_epi64(carry, t[kLimbs52 + i]);
+      r[i] = _mm512_and_si512(carry, mask);
+      carry = _mm512_srli_epi64(carry, 52);
+    }
+    ReduceOnce(r);
+    Store(r, result);
+  }
+
+  [[gnu::target("avx512f,avx512ifma")]] static void Add(const FieldLanes& a,
+                                                        const FieldLanes& b,
+                                                        FieldLanes& result) {
+    const __m512i mask = _mm512_set1_epi64(kLimbMask52);
+    __m512i av[kLimbs52];
+    __m512i bv[kLimbs52];
+    Load(a, av);
+    Load(b, bv);
+    __m512i carry = _mm512_setzero_si512();
+    for (size_t i = 0; i < kLimbs52; ++i) {
+      carry = _mm512_add_epi64(carry, _mm512_add_epi64(av[i], bv[i]));
+      av[i] = _mm512_and_si512(carry, mask);
+      carry = _mm512_srli_epi64(carry, 52);
+    }
+    ReduceOnce(av);
+    Store(av, result);
+  }
+
+  [[gnu::target("avx512f,avx512ifma")]] static void Sub(const FieldLanes& a,
+                                                        const FieldLanes& b,
+                                                        FieldLanes& result) {
+    const Montgomery52& constants = P256Montgomery52();
+    const __m512i mask = _mm512_set1_epi64(kLimbMask52);
+    __m512i av[kLimbs52];
+    __m512i bv[kLimbs52];
+    Load(a, av);
+    Load(b, bv);
+    __m512i carry = _mm512_setzero_si512();
+    for (size_t i = 0; i < kLimbs52; ++i) {
+      carry = _mm512_add_epi64(carry, _mm512_sub_epi64(av[i], bv[i]));
+      av[i] = _mm512_and_si512(carry, mask);
+      carry = _mm512_srai_epi64(carry, 52);
+    }
+    __mmask8 negative = _mm512_cmplt_epi64_mask(carry,
+                                                _mm512_setzero_si512());
+    carry = _mm512_setzero_si512();
+    for (size_t i = 0; i < kLimbs52; ++i) {
+      __m512i sum = _mm512_add_epi64(
+              carry, _mm512_mask_add_epi64(
+                      av[i], negative, av[i],
+                      _mm512_set1_epi64(constants.modulus[i])));
+      av[i] = _mm512_and_si512(sum, mask);
+      carry = _mm512_srli_epi64(sum, 52);
+    }
+    Store(av, result);
+  }
+
+  [[gnu::target("avx512f,avx512ifma")]] static uint32_t IsZero(
+          const FieldLanes& x) {
+    __m512i bits = _mm512_setzero_si512();
+    for (size_t i = 0; i < kLimbs52; ++i) {
+      bits = _mm512_or_si512(bits, _mm512_load_si512(x.limbs[i]));
+    }
+    return _mm512_cmpeq_epi64_mask(bits, _mm512_setzero_si512());
+  }
+
+ private:
+  [[gnu::target("avx512f,avx512ifma")]] static void Load(
+          const FieldLanes& x, __m512i (&v)[kLimbs52]) {
+    for (size_t i = 0; i < kLimbs52; ++i) {
+      v[i] = _mm512_load_si512(x.limbs[i]);
+    }
+  }
+
+  [[gnu::target("avx512f,avx512ifma")]] static void Store(
+          const __m512i (&v)[kLimbs52], FieldLanes& x) {
+    for (size_t i = 0; i < kLimbs52; ++i) {
+      _mm512_store_si512(x.limbs[i], v[i]);
+    }
+  }
+
+  // Subtracts p in the lanes where x >= p, x must be below 2p.
+  [[gnu::target("avx512f,avx512ifma")]] static void ReduceOnce(
+          __m512i (&x)[kLimbs52]) {
+    const Montgomery52& constants = P256Montgomery52();
+    const __m512i mask = _mm512_set1_epi64(kLimbMask52);
+    __m512i difference[kLimbs52];
+    __m512i carry = _mm512_setzero_si512();
+    for (size_t i = 0; i < kLimbs52; ++i) {
+      carry = _mm512_add_epi64(carry, _mm512_sub_epi64(
+              x[i], _mm512_set1_epi64(constants.modulus[i])));
+      difference[i] = _mm512_and_si512(carry, mask);
+      carry = _mm512_srai_epi64(carry, 52);
+    }
+    __mmask8 keep = _mm512_cmplt_epi64_mask(carry, _mm512_setzero_si512());
+    for (size_t i = 0; i < kLimbs52; ++i) {
+      x[i] = _mm512_mask_blend_epi64(keep, difference[i], x[i]);
+    }
+  }
+};
+#pragma GCC diagnostic pop
+
+#endif
+
+// madd-2007-bl on all lanes. Returns the mask of lanes where h = 0: there the
+// addends are equal or opposite and the result is not valid.
+template<typename Kernel>
+uint32_t AddMixed(const PointLanes& p1, const FieldLanes& x2,
+                  const FieldLanes& y2, PointLanes& result) {
+  FieldLanes z1_z1, u2, s2, h, r, hh, i, j, v, t;
+  Kernel::Mul(p1.z, p1.z, z1_z1);
+  Kernel::Mul(x2, z1_z1, u2);
+  Kernel::Mul(y2, p1.z, s2);
+  Kernel::Mul(s2, z1_z1, s2);
+  Kernel::Sub(u2, p1.x, h);
+  uint32_t h_zero = Kernel::IsZero(h);
+  Kernel::Sub(s2, p1.y, r);
+  Kernel::Add(r, r, r);
+  Kernel::Mul(h, h, hh);
+  Kernel::Add(hh, hh, i);
+  Kernel::Add(i, i, i);
+  Kernel::Mul(h, i, j);
+  Kernel::Mul(p1.x, i, v);
+  // z3 = (z1 + h)^2 - z1z1 - hh, computed first as p1 may alias result.
+  Kernel::Add(p1.z, h, t);
+  Kernel::Mul(t, t, t);
+  Kernel::Sub(t, z1_z1, t);
+  Kernel::Sub(t, hh, result.z);
+  // y1 j is needed for y3 before y1 is overwritten.
+  FieldLanes y1_j;
+  Kernel::Mul(p1.y, j, y1_j);
+  Kernel::Add(y1_j, y1_j, y1_j);
+  // x3 = r^2 - j - 2 v.
+  Kernel::Mul(r, r, t);
+  Kernel::Sub(t, j, t);
+  Kernel::Sub(t, v, t);
+  Kernel::Sub(t, v, result.x);
+  // y3 = r (v - x3) - 2 y1 j.
+  Kernel::Sub(v, result.x, t);
+  Kernel::Mul(r, t, t);
+  Kernel::Sub(t, y1_j, result.y);
+  return h_zero;
+}
+
+// Multiples j * 2^(window_bits * i) * base for every window i of a scalar,
+// so multiplying the base costs one addition per window and no doublings.
+// Each extra window bit halves the additions and doubles the table.
+template<typename Curve>
+class FixedBaseTable {
+ public:
+  using Scalar = typename Curve::Scalar;
+
+  static constexpr int kDefaultWindowBits = 6;
+
+  explicit FixedBaseTable(const BasicCurvePoint<Curve>& base,
+                          int window_bits = kDefaultWindowBits)
+          : window_bits_(window_bits) {
+    size_t window_size = size_t{1} << window_bits_;
+    size_t windows = (Scalar::num_bits + window_bits_ - 1) / window_bits_;
+    std::vector<BasicJacobianPoint<Curve>> table;
+    table.reserve(windows * window_size);
+    BasicJacobianPoint<Curve> row_base(base);
+    for (size_t i = 0; i < windows; ++i) {
+      table.emplace_back();
+      for (size_t j = 1; j < window_size; ++j) {
+        table.push_back(table.back() * row_base);
+      }
+      row_base = table.back() * row_base;
+    }
+    table_ = ToAffine(table);
+    if constexpr (std::is_same_v<Curve, P256>) {
+      lane_table_.resize(table_.size());
+      for (size_t i = 0; i < table_.size(); ++i) {
+        if (!table_[i].IsInf()) {
+          lane_table_[i] = {ToMontgomery52(table_[i].GetX()),
+                            ToMontgomery52(table_[i].GetY())};
+        }
+      }
+    }
+  }
+
+  // Returns k * base.
+  [[nodiscard]] BasicJacobianPoint<Curve> MulBase(const Scalar& k) const {
+    size_t window_size = size_t{1} << window_bits_;
+    BasicJacobianPoint<Curve> result;
+    for (size_t i = 0; i * window_size < table_.size(); ++i) {
+      auto digit = static_cast<size_t>(k >> (i * window_bits_)) &
+                   (window_size - 1);
+      if (digit != 0) {
+        result = result * table_[i * window_size + digit];
+      }
+    }
+    return result;
+  }
+
+  // Returns k * base for every scalar.
+  [[nodiscard]] std::vector<BasicJacobianPoint<Curve>>
+  MulBaseBatch(const std::vector<Scalar>& scalars) const {
+    if constexpr (std::is_same_v<Curve, P256>) {
+#if HAS_X86_SIMD
+      if (__builtin_cpu_supports("avx512ifma")) {
+        return MulBaseLanes<Avx512IfmaLanes>(scalars);
+      }
+      if (__builtin_cpu_supports("avx2")) {
+        return MulBaseLanes<Avx2Lanes>(scalars);
+      }
+#endif
+      return MulBaseLanes<PortableLanes>(scalars);
+    } else {
+      std::vector<BasicJacobianPoint<Curve>> result;
+      result.reserve(scalars.size());
+      for (const Scalar& k : scalars) {
+        result.push_back(MulBase(k));
+      }
+      return result;
+    }
+  }
+
+ private:
+  // P-256 only: runs kLanes scalars at a time on the given lane kernel. Lanes
+  // that hit an addition of equal or opposite points fall back to MulBase.
+  template<typename Kernel>
+  [[nodiscard]] std::vector<BasicJacobianPoint<Curve>>
+  MulBaseLanes(const std::vector<Scalar>& scalars) const {
+    std::vector<BasicJacobianPoint<Curve>> result(scalars.size());
+    size_t window_size = size_t{1} << window_bits_;
+    FieldLanes one{};
+    for (size_t lane = 0; lane < kLanes; ++lane) {
+      SetLane(one, lane, P256Montgomery52().one);
+    }
+    for (size_t begin = 0; begin < scalars.size(); begin += kLanes) {
+      size_t lanes = std::min(kLanes, scalars.size() - begin);
+      PointLanes sum{};
+      uint32_t inf = kAllLanes;
+      uint32_t exceptional = 0;
+      for (size_t i = 0; i * window_size < table_.size(); ++i) {
+        FieldLanes x{};
+        FieldLanes y{};
+        uint32_t skip = 0;
+        for (size_t lane = 0; lane < kLanes; ++lane) {
+          size_t digit = 0;
+          if (lane < lanes) {
+            digit = static_cast<size_t>(scalars[begin + lane] >>
+                                        (i * window_bits_)) &
+                    (window_size - 1);
+          }
+          if (digit == 0) {
+            skip |= uint32_t{1} << lane;
+          }
+          const auto& entry = lane_table_[i * window_size + digit];
+          SetLane(x, lane, entry.first);
+          SetLane(y, lane, entry.second);
+        }
+        PointLanes next;
+        uint32_t h_zero = AddMixed<Kernel>(sum, x, y, next);
+        uint32_t add = ~inf & ~skip & kAllLanes;
+        uint32_t load = inf & ~skip;
+        exceptional |= h_zero & add;
+        Select(add, next.x, sum.x);
+        Select(add, next.y, sum.y);
+        Select(add, next.z, sum.z);
+        Select(load, x, sum.x);
+        Select(load, y, sum.y);
+        Select(load, one, sum.z);
+        inf &= skip;
+      }
+      for (size_t lane = 0; lane < lanes; ++lane) {
+        if (((exceptional >> lane) & 1) != 0) {
+          result[begin + lane] = MulBase(scalars[begin + lane]);
+        } else if (((inf >> lane) & 1) == 0) {
+          result[begin + lane] = {FromMontgomery52(GetLane(sum.x, lane)),
+                                  FromMontgomery52(GetLane(sum.y, lane)),
+                                  FromMontgomery52(GetLane(sum.z, lane))};
+        }
+      }
+    }
+    return result;
+  }
+
+  int window_bits_;
+  std::vector<BasicCurvePoint<Curve>> table_;
+  // table_ in the radix-2^52 Montgomery form used by MulBaseBatch.
+  std::vector<std::pair<Limbs52, Limbs52>> lane_table_;
+};
+
 }  // namespace math
 
 namespace encoding {
@@ -2048,25 +3450,6 @@ int EncodeChar(char c) {
   return 64;
 }
 
-char DecodeChar(int num) {
-  if (0 <= num && num <= 9) {
-    return static_cast<char>('0' + num);
-  }
-  if (10 <= num && num <= 35) {
-    return static_cast<char>('A' + num - 10);
-  }
-  if (36 <= num && num <= 61) {
-    return static_cast<char>('a' + num - 36);
-  }
-  if (num == 62) {
-    return '_';
-  }
-  if (num == 63) {
-    return '.';
-  }
-  return '\0';
-}
-
 intx::u5 EncodeString(const std::string& s) {
   std::vector<int> encoded_values;
   encoded_values.reserve(s.size());
@@ -2081,151 +3464,586 @@ intx::u5 EncodeString(const std::string& s) {
   return result;
 }
 
-std::string DecodeString(const math::Number& number) {
-  std::string s;
-  for (size_t i = 0; i < number.Size(); ++i) {
-    s.push_back(DecodeChar(number.GetDigit(i)));
+}  // namespace encoding
+
+namespace io {
+
+constexpr size_t kBufferSize = 1 << 16;
+
+// Buffered input on top of fread with hand-rolled integer parsing. It can
+// also parse a memory region in place, e.g. a mapped file.
+class Reader {
+ public:
+  explicit Reader(FILE* file)
+          : file_(file), buffer_(kBufferSize), data_(buffer_.data()) {}
+
+  Reader(const char* data, size_t size)
+          : file_(nullptr), data_(data), size_(size) {}
+
+  Reader(const Reader&) = delete;
+  Reader& operator=(const Reader&) = delete;
+
+  // Returns the next character without extracting it, or EOF.
+  int Peek() {
+    if (pos_ == size_ && !Refill()) {
+      return EOF;
+    }
+    return static_cast<unsigned char>(data_[pos_]);
   }
-  return s;
+
+  int Get() {
+    int c = Peek();
+    if (c != EOF) {
+      ++pos_;
+    }
+    return c;
+  }
+
+  void SkipSpaces() {
+    for (int c = Peek(); c == ' ' || c == '\n' || c == '\r' || c == '\t';
+         c = Peek()) {
+      ++pos_;
+    }
+  }
+
+  // Reads an unsigned decimal number, returns false if there is none.
+  bool Read(uint64_t& x) {
+    SkipSpaces();
+    int c = Peek();
+    if (c < '0' || c > '9') {
+      return false;
+    }
+    x = 0;
+    for (; c >= '0' && c <= '9'; c = Peek()) {
+      x = x * 10 + (c - '0');
+      ++pos_;
+    }
+    return true;
+  }
+
+  // Reads a whitespace-separated token, returns false at the end of input.
+  bool ReadToken(std::string& token) {
+    SkipSpaces();
+    token.clear();
+    for (int c = Peek(); c != EOF && c != ' ' && c != '\n' && c != '\r' &&
+                         c != '\t'; c = Peek()) {
+      token.push_back(static_cast<char>(c));
+      ++pos_;
+    }
+    return !token.empty();
+  }
+
+  // Reads the rest of the current line and extracts the line break. Returns
+  // false at the end of input.
+  bool ReadLine(std::string& line) {
+    line.clear();
+    if (Peek() == EOF) {
+      return false;
+    }
+    while (pos_ < size_ || Refill()) {
+      const char* begin = data_ + pos_;
+      const char* end = static_cast<const char*>(
+              std::memchr(begin, '\n', size_ - pos_));
+      if (end != nullptr) {
+        line.append(begin, end);
+        pos_ += end - begin + 1;
+        return true;
+      }
+      line.append(begin, size_ - pos_);
+      pos_ = size_;
+    }
+    return true;
+  }
+
+  // Reads up to n next characters of the current line, leaving the line
+  // break in place. Returns false when the line is exhausted.
+  bool ReadLineChunk(std::string& chunk, size_t n) {
+    chunk.clear();
+    while (chunk.size() < n && (pos_ < size_ || Refill())) {
+      const char* begin = data_ + pos_;
+      size_t available = std::min(size_ - pos_, n - chunk.size());
+      const char* end = static_cast<const char*>(
+              std::memchr(begin, '\n', available));
+      if (end != nullptr) {
+        chunk.append(begin, end);
+        pos_ += end - begin;
+        break;
+      }
+      chunk.append(begin, available);
+      pos_ += available;
+    }
+    return !chunk.empty();
+  }
+
+  // Reads n raw bytes, returns false if the input ends earlier.
+  bool ReadBytes(void* data, size_t n) {
+    auto* out = static_cast<char*>(data);
+    while (n > 0 && (pos_ < size_ || Refill())) {
+      size_t available = std::min(size_ - pos_, n);
+      std::memcpy(out, data_ + pos_, available);
+      pos_ += available;
+      out += available;
+      n -= available;
+    }
+    return n == 0;
+  }
+
+  // Reads a little-endian integer of the given width in bytes.
+  bool ReadLe(uint64_t& x, size_t bytes = sizeof(uint64_t)) {
+    uint8_t buffer[sizeof(uint64_t)];
+    if (!ReadBytes(buffer, bytes)) {
+      return false;
+    }
+    x = 0;
+    for (size_t i = bytes; i > 0; --i) {
+      x = (x << 8) | buffer[i - 1];
+    }
+    return true;
+  }
+
+ private:
+  bool Refill() {
+    if (file_ == nullptr) {
+      return false;
+    }
+    pos_ = 0;
+    size_ = std::fread(buffer_.data(), 1, buffer_.size(), file_);
+    return size_ > 0;
+  }
+
+  FILE* file_;
+  std::vector<char> buffer_;
+  const char* data_;
+  size_t pos_ = 0;
+  size_t size_ = 0;
+};
+
+// Buffered output on top of fwrite, flushed on destruction.
+class Writer {
+ public:
+  explicit Writer(FILE* file) : file_(file), buffer_(kBufferSize) {}
+
+  Writer(const Writer&) = delete;
+  Writer& operator=(const Writer&) = delete;
+
+  ~Writer() {
+    Flush();
+  }
+
+  void Write(char c) {
+    if (pos_ == buffer_.size()) {
+      Flush();
+    }
+    buffer_[pos_++] = c;
+  }
+
+  void Write(uint64_t x) {
+    char digits[20];
+    size_t n = 0;
+    do {
+      digits[n++] = static_cast<char>('0' + x % 10);
+      x /= 10;
+    } while (x > 0);
+    if (buffer_.size() - pos_ < n) {
+      Flush();
+    }
+    while (n > 0) {
+      buffer_[pos_++] = digits[--n];
+    }
+  }
+
+  void Write(const std::string& s) {
+    WriteBytes(s.data(), s.size());
+  }
+
+  void WriteBytes(const void* data, size_t n) {
+    const auto* in = static_cast<const char*>(data);
+    for (size_t written = 0; written < n;) {
+      if (pos_ == buffer_.size()) {
+        Flush();
+      }
+      size_t count = std::min(n - written, buffer_.size() - pos_);
+      std::memcpy(buffer_.data() + pos_, in + written, count);
+      pos_ += count;
+      written += count;
+    }
+  }
+
+  // Writes the lowest bytes of x in little-endian order.
+  void WriteLe(uint64_t x, size_t bytes = sizeof(uint64_t)) {
+    uint8_t buffer[sizeof(uint64_t)];
+    for (size_t i = 0; i < bytes; ++i) {
+      buffer[i] = static_cast<uint8_t>(x >> (8 * i));
+    }
+    WriteBytes(buffer, bytes);
+  }
+
+  void Flush() {
+    std::fwrite(buffer_.data(), 1, pos_, file_);
+    pos_ = 0;
+  }
+
+ private:
+  FILE* file_;
+  std::vector<char> buffer_;
+  size_t pos_ = 0;
+};
+
+// Binary ciphertext format, version 2. It has the layout of version 1
+// written by A and C except that the modulus takes 32 bytes. All integers are
+// little-endian:
+//   "EGCT", u32 version, u32 value width in bytes (32), u32 values per
+//   element (2 coordinates of a point, or 1 if compressed), 256-bit modulus,
+//   u64 number of pairs,
+// followed by the pairs of points. A compressed point is the SEC1 tag byte
+// (2 for even y, 3 for odd y) followed by x.
+constexpr char kBinaryMagic[4] = {'E', 'G', 'C', 'T'};
+constexpr uint64_t kBinaryVersion = 2;
+constexpr uint64_t kBinaryWidth = 32;
+
+void WriteUint256(Writer& writer, const intx::uint256& x) {
+  uint8_t bytes[kBinaryWidth];
+  intx::le::store(bytes, x);
+  writer.WriteBytes(bytes, sizeof(bytes));
 }
 
-}  // namespace encoding
+void WriteBinaryHeader(Writer& writer, const intx::uint256& modulus,
+                       uint64_t count, bool compressed) {
+  writer.WriteBytes(kBinaryMagic, sizeof(kBinaryMagic));
+  writer.WriteLe(kBinaryVersion, 4);
+  writer.WriteLe(kBinaryWidth, 4);
+  writer.WriteLe(compressed ? 1 : 2, 4);  // Coordinates per point.
+  WriteUint256(writer, modulus);
+  writer.WriteLe(count);
+}
+
+}  // namespace io
 
 namespace string_utils {
 
+// 10^19, the largest power of ten in a word. Its top bit is set, so it is
+// already normalized for the 2-by-1 division with a precomputed reciprocal.
+const uint64_t kDecimalChunk = 10000000000000000000u;
+const size_t kDecimalChunkDigits = 19;
+
+// Converts 19 digits at a time: each chunk is one pass of word divisions by
+// 10^19, multiplications by a reciprocal instead of a 512-bit division.
 std::string ToString(intx::u5 num) {
-  std::string result;
-  while (num > 0) {
-    result.push_back(char('0' + (num % 10)));
-    num /= 10;
+  static const uint64_t reciprocal = intx::reciprocal_2by1(kDecimalChunk);
+  uint64_t chunks[intx::u5::num_words + 1];
+  size_t chunks_count = 0;
+  size_t len = intx::u5::num_words;
+  while (len > 0 && num[len - 1] == 0) {
+    --len;
+  }
+  while (len > 0) {
+    uint64_t rem = 0;
+    for (size_t i = len; i > 0; --i) {
+      auto result = intx::udivrem_2by1({num[i - 1], rem}, kDecimalChunk,
+                                       reciprocal);
+      num[i - 1] = result.quot;
+      rem = result.rem;
+    }
+    chunks[chunks_count++] = rem;
+    while (len > 0 && num[len - 1] == 0) {
+      --len;
+    }
+  }
+  if (chunks_count == 0) {
+    return "0";
+  }
+  std::string result = std::to_string(chunks[chunks_count - 1]);
+  for (size_t i = chunks_count - 1; i > 0; --i) {
+    char digits[kDecimalChunkDigits];
+    uint64_t chunk = chunks[i - 1];
+    for (size_t j = kDecimalChunkDigits; j > 0; --j) {
+      digits[j - 1] = static_cast<char>('0' + chunk % 10);
+      chunk /= 10;
+    }
+    result.append(digits, kDecimalChunkDigits);
   }
-  std::reverse(result.begin(), result.end());
   return result;
 }
 
-void PrintPoint(const math::CurvePoint& point, std::ostream& out) {
-  std::cout << ToString(point.GetX()) << " " << ToString(point.GetY()) << "\n";
+void PrintPoint(const math::CurvePoint& point, io::Writer& out) {
+  out.Write(ToString(point.GetX().ToU5()));
+  out.Write(' ');
+  out.Write(ToString(point.GetY().ToU5()));
+  out.Write('\n');
+}
+
+void WritePointBinary(const math::CurvePoint& point, io::Writer& out) {
+  io::WriteUint256(out, point.GetX().Value());
+  io::WriteUint256(out, point.GetY().Value());
+}
+
+// The compressed text form of a point is the single number 2 x + (y mod 2).
+void PrintPointCompressed(const math::CurvePoint& point, io::Writer& out) {
+  intx::u5 compressed = point.GetX().ToU5() << 1;
+  if (point.GetY().IsOdd()) {
+    compressed += 1;
+  }
+  out.Write(ToString(compressed));
+  out.Write('\n');
 }
 
+void WritePointCompressedBinary(const math::CurvePoint& point,
+                                io::Writer& out) {
+  out.WriteLe(point.GetY().IsOdd() ? 3 : 2, 1);
+  io::WriteUint256(out, point.GetX().Value());
+}
+
+// Accumulates up to 19 digits in a word, then folds them in with a single
+// word-by-number multiply-add.
 intx::u5 StringTou5(const std::string& num_string) {
   intx::u5 result = 0;
-  for (char c : num_string) {
-    result *= 10;
-    result += (c - '0');
+  for (size_t begin = 0; begin < num_string.size();
+       begin += kDecimalChunkDigits) {
+    size_t end = std::min(begin + kDecimalChunkDigits, num_string.size());
+    uint64_t chunk = 0;
+    uint64_t scale = 1;
+    for (size_t i = begin; i < end; ++i) {
+      chunk = chunk * 10 + (num_string[i] - '0');
+      scale *= 10;
+    }
+    uint64_t carry = chunk;
+    for (size_t i = 0; i < intx::u5::num_words; ++i) {
+      math::uint128 current = static_cast<math::uint128>(result[i]) * scale +
+                              carry;
+      result[i] = static_cast<uint64_t>(current);
+      carry = static_cast<uint64_t>(current >> 64);
+    }
   }
   return result;
 }
 
+// Parses a decimal number of at most 154 digits, so that it fits in u5.
+bool ParseNumber(const std::string& num_string, intx::u5& x) {
+  if (num_string.empty() || num_string.size() > 154 ||
+      num_string.find_first_not_of("0123456789") != std::string::npos) {
+    return false;
+  }
+  x = StringTou5(num_string);
+  return true;
+}
+
+// Parses the public key at the front of the input tokens: "x y", or with
+// compressed set the single number 2 x + (y mod 2). Returns the number of
+// tokens taken by the key, or 0 if they are not a point on the curve.
+size_t ParsePublicKey(const std::vector<std::string>& tokens, bool compressed,
+                      math::CurvePoint& key) {
+  using Field = math::P256Field;
+  const intx::u5 modulus = Field::kModulus;
+  intx::u5 first;
+  intx::u5 second;
+  if (compressed) {
+    if (tokens.empty() || !ParseNumber(tokens[0], first) ||
+        (first >> 1) >= modulus) {
+      return 0;
+    }
+    try {
+      key = math::Decompress<math::P256>(Field(first >> 1),
+                                         (first[0] & 1) != 0);
+    } catch (const std::runtime_error&) {
+      return 0;
+    }
+    return 1;
+  }
+  if (tokens.size() < 2 || !ParseNumber(tokens[0], first) ||
+      !ParseNumber(tokens[1], second)) {
+    return 0;
+  }
+  if (first >= modulus || second >= modulus) {
+    return 0;
+  }
+  Field x(first);
+  Field y(second);
+  if (y.Square() != x.Square() * x + math::P256::kA * x + math::P256::kB) {
+    return 0;
+  }
+  key = {x, y};
+  return 2;
+}
+
 }  // namespace string_utils
 
 namespace crypto {
 
-std::pair<uint64_t, uint64_t>
-Encrypt(uint64_t message, uint64_t p, uint64_t g, uint64_t public_key,
-        std::mt19937 gen) {
-  // Generate random integer from [1, p - 1].
-  uint64_t b = 1 + gen() % (p - 1);
-  // ElGamal encryption.
-  uint64_t g_b = math::BinPow(g, b, /*mod=*/p);
-  uint64_t g_ab = math::BinPow(public_key, b, /*mod=*/p);
-  uint64_t encrypted = math::Mul(message, g_ab, /*mod=*/p);
-  return {g_b, encrypted};
-}
-
-uint64_t Decrypt(std::pair<uint64_t, uint64_t> encrypted_message, uint64_t p,
-                 uint64_t private_key) {
-  uint64_t g_b = encrypted_message.first;
-  uint64_t actual_encrypted_message = encrypted_message.second;
-  uint64_t g_ab = math::BinPow(g_b, private_key, /*mod=*/p);
-  uint64_t g_ab_inv = math::BinPow(g_ab, p - 2, /*mod=*/p);
-  return math::Mul(actual_encrypted_message, g_ab_inv, /*mod=*/p);
+// Generates random integer from [1, group_size - 1]. Whole 256-bit values are
+// drawn until one falls below group_size - 1, so there is no modulo bias.
+intx::uint256 RandomScalar(const intx::uint256& group_size,
+                           std::mt19937_64& gen) {
+  intx::uint256 k;
+  do {
+    for (size_t i = 0; i < intx::uint256::num_words; ++i) {
+      k[i] = gen();
+    }
+  } while (k >= group_size - 1);
+  return k + 1;
+}
+
+// EC-ElGamal encryption of messages[i] with the ephemeral scalar k[i]:
+// (k g, message + k public_key). Both bases are fixed, so the multiplications
+// go through their tables in SIMD batches.
+std::vector<std::pair<math::JacobianPoint, math::JacobianPoint>>
+EncryptBatch(const std::vector<math::CurvePoint>& messages,
+             const math::FixedBaseTable<math::P256>& g,
+             const math::FixedBaseTable<math::P256>& public_key,
+             const std::vector<intx::uint256>& k) {
+  std::vector<math::JacobianPoint> ephemeral = g.MulBaseBatch(k);
+  std::vector<math::JacobianPoint> shared = public_key.MulBaseBatch(k);
+  std::vector<std::pair<math::JacobianPoint, math::JacobianPoint>> result;
+  result.reserve(messages.size());
+  for (size_t i = 0; i < messages.size(); ++i) {
+    result.emplace_back(ephemeral[i], shared[i] * messages[i]);
+  }
+  return result;
 }
 
-math::CurvePoint
-Encrypt(const math::CurvePoint& message, const math::CurvePoint& public_key) {
-  return message * public_key;
+math::P256Field
+CurveRhs(math::P256Field x) {
+  return x.Square() * x + math::P256::kA * x + math::P256::kB;
 }
 
 bool
-CheckPoint(intx::u5 x, intx::u5 a, intx::u5 b, intx::u5 p) {
-  intx::u5 x_3 = (((x * x) % p) * x) % p;
-  intx::u5 a_x = (a * x) % p;
-  intx::u5 y_2 = (x_3 + a_x + b) % p;
-  intx::u5 k = (p - 1) / 2;
-  intx::u5 y_k = math::BinPow(y_2, k, p);
-  return y_k == 1;
-}
-
-intx::u5
-FindY(intx::u5 x, intx::u5 a, intx::u5 b, intx::u5 p) {
-  intx::u5 k = p + 1;
-  k = k / 4;
-  intx::u5 x_3 = (((x * x) % p) * x) % p;
-  intx::u5 a_x = (a * x) % p;
-  intx::u5 y_2 = (x_3 + a_x + b) % p;
-  return math::BinPow(y_2, k, p);
+CheckPoint(math::P256Field x) {
+  intx::uint256 k = (math::P256Field::kModulus - 1) / 2;
+  return CurveRhs(x).Pow(k) == math::P256Field(1);
+}
+
+math::P256Field
+FindY(math::P256Field x) {
+  intx::uint256 k = (math::P256Field::kModulus + 1) / 4;
+  return CurveRhs(x).Pow(k);
+}
+
+const int kSaltBits = 8;
+
+// Messages must be below this bound for the salted value to stay below the
+// field modulus; every text of up to 41 characters is.
+const intx::u5 kMessageLimit =
+        intx::u5(math::P256Field::kModulus) >> kSaltBits;
+
+// Appends random salt bits to the message until it becomes the x-coordinate
+// of a curve point, which takes two attempts on average. The message is
+// recovered as x >> kSaltBits.
+math::P256Field
+AddSalt(intx::u5 message, std::mt19937_64& gen) {
+  assert(message < kMessageLimit);
+  while (true) {
+    math::P256Field x((message << kSaltBits) |
+                      (gen() & ((1 << kSaltBits) - 1)));
+    if (CheckPoint(x)) {
+      return x;
+    }
+  }
 }
 
 math::CurvePoint
-EncodeMessage(intx::u5 message, intx::u5 a,
-              intx::u5 b, intx::u5 p,
-              std::mt19937& gen) {
-  intx::u5 x = message;  // AddSalt(message, a, b, p, gen);
-  intx::u5 y = FindY(x, a, b, p);
-  return {x, y, a, b, p};
+EncodeMessage(intx::u5 message, std::mt19937_64& gen) {
+  math::P256Field x = AddSalt(message, gen);
+  math::P256Field y = FindY(x);
+  return {x, y};
 }
 
 }  // namespace crypto
 
-int main() {
+int main(int argc, char* argv[]) {
 #ifdef LOCAL
   freopen("input.txt", "r", stdin);
   freopen("output.txt", "w", stdout);
 #endif
+  // Parse options. With --binary the output uses the binary format, with
+  // --compressed points are written as x and the parity of y, and with
+  // --compressed-key the public key is read in that form too. The generator is
+  // seeded from std::random_device unless --seed=N fixes it for reproducible
+  // runs.
+  bool binary = false;
+  bool compressed = false;
+  bool compressed_key = false;
+  std::random_device device;
+  uint64_t seed = (static_cast<uint64_t>(device()) << 32) | device();
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--binary") {
+      binary = true;
+    } else if (arg == "--compressed") {
+      compressed = true;
+    } else if (arg == "--compressed-key") {
+      compressed_key = true;
+    } else if (arg.rfind("--seed=", 0) == 0) {
+      seed = std::stoull(arg.substr(7));
+    }
+  }
+
   // Declare general variables.
-  intx::u5 p = string_utils::StringTou5(/*num_string=*/
-          "11579208921035624876269744694940757353008614341529031419553363130886"
-          "7097853951");
-  intx::u5 a = p - 3;
-  intx::u5 b = string_utils::StringTou5(/*num_string=*/
-          "41058363725152142129326129780047268409114441015993725554835256314039467401291");
-  b = b % p;
-  intx::u5 g_x = string_utils::StringTou5(/*num_string=*/
-          "48439561293906451759052585252797914202762949526041747995844080717082404635286");
-  g_x = g_x % p;
-  intx::u5 g_y = string_utils::StringTou5(/*num_string=*/
-          "36134250956749795798585127919587881956611106672985015071877198253568414405109");
-  g_y = g_y % p;
-  intx::u5 group_size = string_utils::StringTou5(/*num_string=*/
-          "115792089210356248762697446949407573529996955224135760342422259061068512044369");
-  math::CurvePoint g(g_x, g_y, a, b, p);
-
-  // Read input.
-  std::string public_key_x_string, public_key_y_string;
-  std::cin >> public_key_x_string >> public_key_y_string;
-  intx::u5 public_key_x = string_utils::StringTou5(
-          public_key_x_string);
-  intx::u5 public_key_y = string_utils::StringTou5(
-          public_key_y_string);
-  math::CurvePoint public_key(public_key_x, public_key_y,
-                              a, b, p);
-  size_t n;
-  std::cin >> n;
+  math::CurvePoint g(math::P256::kGx, math::P256::kGy);
+
+  // Read input: the public key, possibly compressed, the number of texts and
+  // the texts.
+  io::Reader reader(stdin);
+  io::Writer writer(stdout);
+  std::vector<std::string> tokens;
+  for (std::string token; reader.ReadToken(token);) {
+    tokens.push_back(token);
+  }
+  math::CurvePoint public_key;
+  size_t key_size = string_utils::ParsePublicKey(tokens, compressed_key,
+                                                   public_key);
+  if (key_size == 0) {
+    std::fprintf(stderr, "Invalid public key\n");
+    return 1;
+  }
+  intx::u5 count = 0;
+  if (key_size < tokens.size() &&
+      !string_utils::ParseNumber(tokens[key_size], count)) {
+    std::fprintf(stderr, "Invalid number of texts\n");
+    return 1;
+  }
   std::vector<intx::u5> data;
-  data.reserve(n);
-  for (size_t i = 0; i < n; ++i) {
-    std::string text;
-    std::cin >> text;
-    data.push_back(encoding::EncodeString(text));
+  for (size_t i = key_size + 1; i < tokens.size() && count > data.size();
+       ++i) {
+    data.push_back(encoding::EncodeString(tokens[i]));
+    if (data.back() >= crypto::kMessageLimit) {
+      std::fprintf(stderr, "Text is too long: %s\n", tokens[i].c_str());
+      return 1;
+    }
   }
+  size_t n = data.size();
 
   // Encode and print.
-  std::mt19937 gen;
+  math::FixedBaseTable g_table(g);
+  math::FixedBaseTable public_key_table(public_key);
+  std::mt19937_64 gen(seed);
+  if (binary) {
+    io::WriteBinaryHeader(writer, math::P256Field::kModulus, /*count=*/n,
+                          compressed);
+  }
+  std::vector<math::CurvePoint> messages;
+  std::vector<intx::uint256> scalars;
+  messages.reserve(n);
+  scalars.reserve(n);
   for (size_t i = 0; i < n; ++i) {
-    math::CurvePoint point = crypto::EncodeMessage(data[i], a, b, p, gen);
-    point = crypto::Encrypt(point, public_key);
-    string_utils::PrintPoint(g, std::cout);
-    string_utils::PrintPoint(point, std::cout);
+    messages.push_back(crypto::EncodeMessage(data[i], gen));
+    scalars.push_back(crypto::RandomScalar(math::P256::kGroupSize, gen));
+  }
+  std::vector<math::JacobianPoint> encrypted;
+  encrypted.reserve(2 * n);
+  for (const auto& pair :
+          crypto::EncryptBatch(messages, g_table, public_key_table, scalars)) {
+    encrypted.push_back(pair.first);
+    encrypted.push_back(pair.second);
+  }
+  for (const math::CurvePoint& point : math::ToAffine(encrypted)) {
+    if (binary && compressed) {
+      string_utils::WritePointCompressedBinary(point, writer);
+    } else if (binary) {
+      string_utils::WritePointBinary(point, writer);
+    } else if (compressed) {
+      string_utils::PrintPointCompressed(point, writer);
+    } else {
+      string_utils::PrintPoint(point, writer);
+    }
   }
   return 0;
 }
@@ -0,0 +1,3458 @@
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <climits>
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#ifndef __has_builtin
+#define __has_builtin(NAME) 0
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#if !defined(__has_builtin)
+#define __has_builtin(NAME) 0
+#endif
+
+#if !defined(__has_feature)
+#define __has_feature(NAME) 0
+#endif
+
+#if !defined(NDEBUG)
+#define INTX_UNREACHABLE() assert(false)
+#elif __has_builtin(__builtin_unreachable)
+#define INTX_UNREACHABLE() __builtin_unreachable()
+#elif defined(_MSC_VER)
+#define INTX_UNREACHABLE() __assume(0)
+#else
+#define INTX_UNREACHABLE() (void)0
+#endif
+
+
+#if __has_builtin(__builtin_expect)
+#define INTX_UNLIKELY(EXPR) __builtin_expect(bool{EXPR}, false)
+#else
+#define INTX_UNLIKELY(EXPR) (bool{EXPR})
+#endif
+
+#if !defined(NDEBUG)
+#define INTX_REQUIRE assert
+#else
+#define INTX_REQUIRE(X) (X) ? (void)0 : INTX_UNREACHABLE()
+#endif
+
+
+#if defined(__SIZEOF_INT128__)
+#define INTX_HAS_BUILTIN_INT128 1
+#else
+#define INTX_HAS_BUILTIN_INT128 0
+#endif
+
+
+namespace intx {
+#if INTX_HAS_BUILTIN_INT128
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpedantic"  // Usage of __int128 triggers a pedantic warning.
+
+using builtin_uint128 = unsigned __int128;
+
+#pragma GCC diagnostic pop
+#endif
+
+template<unsigned N>
+struct uint;
+
+template<>
+struct uint<128> {
+  using word_type = uint64_t;
+  static constexpr auto word_num_bits = sizeof(word_type) * 8;
+  static constexpr unsigned num_bits = 128;
+  static constexpr auto num_words = num_bits / word_num_bits;
+
+ private:
+  uint64_t words_[2]{};
+
+ public:
+  constexpr uint() noexcept = default;
+
+  constexpr uint(uint64_t low, uint64_t high) noexcept: words_{low, high} {}
+
+  template<typename T,
+          typename = typename std::enable_if_t<std::is_convertible<T, uint64_t>::value>>
+  constexpr uint(T x) noexcept : words_{static_cast<uint64_t>(x), 0}  // NOLINT
+  {}
+
+#if INTX_HAS_BUILTIN_INT128
+
+  constexpr uint(builtin_uint128 x) noexcept  // NOLINT
+          : words_{uint64_t(x), uint64_t(x >> 64)} {}
+
+  constexpr explicit operator builtin_uint128() const noexcept {
+    return (builtin_uint128{words_[1]} << 64) | words_[0];
+  }
+
+#endif
+
+  constexpr uint64_t& operator[](size_t i) noexcept { return words_[i]; }
+
+  constexpr const uint64_t&
+  operator[](size_t i) const noexcept { return words_[i]; }
+
+  constexpr explicit operator bool() const noexcept {
+    return (words_[0] | words_[1]) != 0;
+  }
+
+  template<typename Int, typename = typename std::enable_if<std::is_integral<Int>::value>::type>
+  constexpr explicit operator Int() const noexcept {
+    return static_cast<Int>(words_[0]);
+  }
+};
+
+using uint128 = uint<128>;
+
+
+inline constexpr bool is_constant_evaluated() noexcept {
+#if __has_builtin(__builtin_is_constant_evaluated) || (defined(_MSC_VER) && _MSC_VER >= 1925)
+  return __builtin_is_constant_evaluated();
+#else
+  return true;
+#endif
+}
+
+
+template<typename T>
+struct result_with_carry {
+  T value;
+  bool carry;
+
+  /// Conversion to tuple of references, to allow usage with std::tie().
+  constexpr operator std::tuple<T&, bool&>() noexcept { return {value, carry}; }
+};
+
+
+
+inline constexpr result_with_carry<uint64_t> add_with_carry(
+        uint64_t x, uint64_t y, bool carry = false) noexcept {
+  const auto s = x + y;
+  const auto carry1 = s < x;
+  const auto t = s + carry;
+  const auto carry2 = t < s;
+  return {t, carry1 || carry2};
+}
+
+template<unsigned N>
+inline constexpr result_with_carry<uint<N>> add_with_carry(
+        const uint<N>& x, const uint<N>& y, bool carry = false) noexcept {
+  uint<N> s;
+  bool k = carry;
+  for (size_t i = 0; i < uint<N>::num_words; ++i) {
+    s[i] = x[i] + y[i];
+    const auto k1 = s[i] < x[i];
+    s[i] += k;
+    k = (s[i] < uint64_t{k}) || k1;
+  }
+  return {s, k};
+}
+
+inline constexpr uint128 operator+(uint128 x, uint128 y) noexcept {
+  return add_with_carry(x, y).value;
+}
+
+inline constexpr uint128 operator+(uint128 x) noexcept {
+  return x;
+}
+
+inline constexpr result_with_carry<uint64_t> sub_with_carry(
+        uint64_t x, uint64_t y, bool carry = false) noexcept {
+  const auto d = x - y;
+  const auto carry1 = x < y;
+  const auto e = d - carry;
+  const auto carry2 = d < uint64_t{carry};
+  return {e, carry1 || carry2};
+}
+
+template<unsigned N>
+inline constexpr result_with_carry<uint<N>> sub_with_carry(
+        const uint<N>& x, const uint<N>& y, bool carry = false) noexcept {
+  uint<N> z;
+  bool k = carry;
+  for (size_t i = 0; i < uint<N>::num_words; ++i) {
+    z[i] = x[i] - y[i];
+    const auto k1 = x[i] < y[i];
+    const auto k2 = z[i] < uint64_t{k};
+    z[i] -= k;
+    k = k1 || k2;
+  }
+  return {z, k};
+}
+
+inline constexpr uint128 operator-(uint128 x, uint128 y) noexcept {
+  return sub_with_carry(x, y).value;
+}
+
+inline constexpr uint128 operator-(uint128 x) noexcept {
+  // Implementing as subtraction is better than ~x + 1.
+  // Clang9: Perfect.
+  // GCC8: Does something weird.
+  return 0 - x;
+}
+
+inline uint128& operator++(uint128& x) noexcept {
+  return x = x + 1;
+}
+
+inline uint128& operator--(uint128& x) noexcept {
+  return x = x - 1;
+}
+
+inline uint128 operator++(uint128& x, int) noexcept {
+  auto ret = x;
+  ++x;
+  return ret;
+}
+
+inline uint128 operator--(uint128& x, int) noexcept {
+  auto ret = x;
+  --x;
+  return ret;
+}
+
+inline constexpr uint128 fast_add(uint128 x, uint128 y) noexcept {
+#if INTX_HAS_BUILTIN_INT128
+  return builtin_uint128{x} + builtin_uint128{y};
+#else
+  return x + y;  // Fallback to generic addition.
+#endif
+}
+
+
+
+
+inline constexpr bool operator==(uint128 x, uint128 y) noexcept {
+  // Clang7: generates perfect xor based code,
+  //         much better than __int128 where it uses vector instructions.
+  // GCC8: generates a bit worse cmp based code
+  //       although it generates the xor based one for __int128.
+  return (x[0] == y[0]) & (x[1] == y[1]);
+}
+
+inline constexpr bool operator!=(uint128 x, uint128 y) noexcept {
+  // Analogous to ==, but == not used directly, because that confuses GCC 8-9.
+  return (x[0] != y[0]) | (x[1] != y[1]);
+}
+
+inline constexpr bool operator<(uint128 x, uint128 y) noexcept {
+  // OPT: This should be implemented by checking the borrow of x - y,
+  //      but compilers (GCC8, Clang7)
+  //      have problem with properly optimizing subtraction.
+#if INTX_HAS_BUILTIN_INT128
+  return builtin_uint128{x} < builtin_uint128{y};
+#else
+  return (x[1] < y[1]) | ((x[1] == y[1]) & (x[0] < y[0]));
+#endif
+}
+
+inline constexpr bool operator<=(uint128 x, uint128 y) noexcept {
+  return !(y < x);
+}
+
+inline constexpr bool operator>(uint128 x, uint128 y) noexcept {
+  return y < x;
+}
+
+inline constexpr bool operator>=(uint128 x, uint128 y) noexcept {
+  return !(x < y);
+}
+
+
+
+
+inline constexpr uint128 operator~(uint128 x) noexcept {
+  return {~x[0], ~x[1]};
+}
+
+inline constexpr uint128 operator|(uint128 x, uint128 y) noexcept {
+  // Clang7: perfect.
+  // GCC8: stupidly uses a vector instruction in all bitwise operators.
+  return {x[0] | y[0], x[1] | y[1]};
+}
+
+inline constexpr uint128 operator&(uint128 x, uint128 y) noexcept {
+  return {x[0] & y[0], x[1] & y[1]};
+}
+
+inline constexpr uint128 operator^(uint128 x, uint128 y) noexcept {
+  return {x[0] ^ y[0], x[1] ^ y[1]};
+}
+
+inline constexpr uint128 operator<<(uint128 x, uint64_t shift) noexcept {
+  return (shift < 64) ?
+         // Find the part moved from lo to hi.
+         // For shift == 0 right shift by (64 - shift) is invalid so
+         // split it into 2 shifts by 1 and (63 - shift).
+         uint128{x[0] << shift, (x[1] << shift) | ((x[0] >> 1) >> (63 - shift))}
+                      :
+
+         // Guarantee "defined" behavior for shifts larger than 128.
+         (shift < 128) ? uint128{0, x[0] << (shift - 64)} : 0;
+}
+
+inline constexpr uint128 operator<<(uint128 x, uint128 shift) noexcept {
+  if (INTX_UNLIKELY(shift[1] != 0))
+    return 0;
+
+  return x << shift[0];
+}
+
+inline constexpr uint128 operator>>(uint128 x, uint64_t shift) noexcept {
+  return (shift < 64) ?
+         // Find the part moved from lo to hi.
+         // For shift == 0 left shift by (64 - shift) is invalid so
+         // split it into 2 shifts by 1 and (63 - shift).
+         uint128{(x[0] >> shift) | ((x[1] << 1) << (63 - shift)), x[1] >> shift}
+                      :
+
+         // Guarantee "defined" behavior for shifts larger than 128.
+         (shift < 128) ? uint128{x[1] >> (shift - 64)} : 0;
+}
+
+inline constexpr uint128 operator>>(uint128 x, uint128 shift) noexcept {
+  if (INTX_UNLIKELY(shift[1] != 0))
+    return 0;
+
+  return x >> static_cast<uint64_t>(shift);
+}
+
+
+
+
+inline constexpr uint128 umul(uint64_t x, uint64_t y) noexcept {
+#if INTX_HAS_BUILTIN_INT128
+  return builtin_uint128{x} * builtin_uint128{y};
+#elif defined(_MSC_VER) && _MSC_VER >= 1925
+  if (!is_constant_evaluated())
+  {
+    unsigned __int64 hi = 0;
+    const auto lo = _umul128(x, y, &hi);
+    return {lo, hi};
+  }
+  // For constexpr fallback to portable variant.
+#endif
+
+  uint64_t xl = x & 0xffffffff;
+  uint64_t xh = x >> 32;
+  uint64_t yl = y & 0xffffffff;
+  uint64_t yh = y >> 32;
+
+  uint64_t t0 = xl * yl;
+  uint64_t t1 = xh * yl;
+  uint64_t t2 = xl * yh;
+  uint64_t t3 = xh * yh;
+
+  uint64_t u1 = t1 + (t0 >> 32);
+  uint64_t u2 = t2 + (u1 & 0xffffffff);
+
+  uint64_t lo = (u2 << 32) | (t0 & 0xffffffff);
+  uint64_t hi = t3 + (u2 >> 32) + (u1 >> 32);
+  return {lo, hi};
+}
+
+inline constexpr uint128 operator*(uint128 x, uint128 y) noexcept {
+  auto p = umul(x[0], y[0]);
+  p[1] += (x[0] * y[1]) + (x[1] * y[0]);
+  return {p[0], p[1]};
+}
+
+
+
+
+inline constexpr uint128& operator+=(uint128& x, uint128 y) noexcept {
+  return x = x + y;
+}
+
+inline constexpr uint128& operator-=(uint128& x, uint128 y) noexcept {
+  return x = x - y;
+}
+
+inline uint128& operator*=(uint128& x, uint128 y) noexcept {
+  return x = x * y;
+}
+
+inline constexpr uint128& operator|=(uint128& x, uint128 y) noexcept {
+  return x = x | y;
+}
+
+inline constexpr uint128& operator&=(uint128& x, uint128 y) noexcept {
+  return x = x & y;
+}
+
+inline constexpr uint128& operator^=(uint128& x, uint128 y) noexcept {
+  return x = x ^ y;
+}
+
+inline constexpr uint128& operator<<=(uint128& x, uint64_t shift) noexcept {
+  return x = x << shift;
+}
+
+inline constexpr uint128& operator>>=(uint128& x, uint64_t shift) noexcept {
+  return x = x >> shift;
+}
+
+
+
+inline constexpr unsigned clz_generic(uint32_t x) noexcept {
+  unsigned n = 32;
+  for (int i = 4; i >= 0; --i) {
+    const auto s = unsigned{1} << i;
+    const auto hi = x >> s;
+    if (hi != 0) {
+      n -= s;
+      x = hi;
+    }
+  }
+  return n - x;
+}
+
+inline constexpr unsigned clz_generic(uint64_t x) noexcept {
+  unsigned n = 64;
+  for (int i = 5; i >= 0; --i) {
+    const auto s = unsigned{1} << i;
+    const auto hi = x >> s;
+    if (hi != 0) {
+      n -= s;
+      x = hi;
+    }
+  }
+  return n - static_cast<unsigned>(x);
+}
+
+inline constexpr unsigned clz(uint32_t x) noexcept {
+#ifdef _MSC_VER
+  return clz_generic(x);
+#else
+  return x != 0 ? unsigned(__builtin_clz(x)) : 32;
+#endif
+}
+
+inline constexpr unsigned clz(uint64_t x) noexcept {
+#ifdef _MSC_VER
+  return clz_generic(x);
+#else
+  return x != 0 ? unsigned(__builtin_clzll(x)) : 64;
+#endif
+}
+
+inline constexpr unsigned clz(uint128 x) noexcept {
+  // In this order `h == 0` we get less instructions than in case of `h != 0`.
+  return x[1] == 0 ? clz(x[0]) + 64 : clz(x[1]);
+}
+
+
+inline constexpr uint64_t bswap(uint64_t x) noexcept {
+#if __has_builtin(__builtin_bswap64)
+  return __builtin_bswap64(x);
+#else
+#ifdef _MSC_VER
+  if (!is_constant_evaluated())
+    return _byteswap_uint64(x);
+#endif
+  const auto a =
+          ((x << 8) & 0xFF00FF00FF00FF00) | ((x >> 8) & 0x00FF00FF00FF00FF);
+  const auto b =
+          ((a << 16) & 0xFFFF0000FFFF0000) | ((a >> 16) & 0x0000FFFF0000FFFF);
+  return (b << 32) | (b >> 32);
+#endif
+}
+
+inline constexpr uint128 bswap(uint128 x) noexcept {
+  return {bswap(x[1]), bswap(x[0])};
+}
+
+
+
+template<typename QuotT, typename RemT = QuotT>
+struct div_result {
+  QuotT quot;
+  RemT rem;
+
+  /// Conversion to tuple of references, to allow usage with std::tie().
+  constexpr operator std::tuple<QuotT&, RemT&>() noexcept {
+    return {quot, rem};
+  }
+};
+
+namespace internal {
+inline constexpr uint16_t reciprocal_table_item(uint8_t d9) noexcept {
+  return uint16_t(0x7fd00 / (0x100 | d9));
+}
+
+#define REPEAT4(x)                                                  \
+reciprocal_table_item((x) + 0), reciprocal_table_item((x) + 1), \
+reciprocal_table_item((x) + 2), reciprocal_table_item((x) + 3)
+
+#define REPEAT32(x)                                                                         \
+REPEAT4((x) + 4 * 0), REPEAT4((x) + 4 * 1), REPEAT4((x) + 4 * 2), REPEAT4((x) + 4 * 3), \
+REPEAT4((x) + 4 * 4), REPEAT4((x) + 4 * 5), REPEAT4((x) + 4 * 6), REPEAT4((x) + 4 * 7)
+
+#define REPEAT256()                                                                           \
+REPEAT32(32 * 0), REPEAT32(32 * 1), REPEAT32(32 * 2), REPEAT32(32 * 3), REPEAT32(32 * 4), \
+REPEAT32(32 * 5), REPEAT32(32 * 6), REPEAT32(32 * 7)
+
+constexpr uint16_t reciprocal_table[] = {REPEAT256()};
+
+#undef REPEAT4
+#undef REPEAT32
+#undef REPEAT256
+}  // namespace internal
+
+inline uint64_t reciprocal_2by1(uint64_t d) noexcept {
+          INTX_REQUIRE(d & 0x8000000000000000);  // Must be normalized.
+
+  const uint64_t d9 = d >> 55;
+  const uint32_t v0 = internal::reciprocal_table[d9 - 256];
+
+  const uint64_t d40 = (d >> 24) + 1;
+  const uint64_t v1 = (v0 << 11) - uint32_t(v0 * v0 * d40 >> 40) - 1;
+
+  const uint64_t v2 = (v1 << 13) + (v1 * (0x1000000000000000 - v1 * d40) >> 47);
+
+  const uint64_t d0 = d & 1;
+  const uint64_t d63 = (d >> 1) + d0;  // ceil(d/2)
+  const uint64_t e = ((v2 >> 1) & (0 - d0)) - v2 * d63;
+  const uint64_t v3 = (umul(v2, e)[1] >> 1) + (v2 << 31);
+
+  const uint64_t v4 = v3 - (umul(v3, d) + d)[1] - d;
+  return v4;
+}
+
+inline uint64_t reciprocal_3by2(uint128 d) noexcept {
+  auto v = reciprocal_2by1(d[1]);
+  auto p = d[1] * v;
+  p += d[0];
+  if (p < d[0]) {
+    --v;
+    if (p >= d[1]) {
+      --v;
+      p -= d[1];
+    }
+    p -= d[1];
+  }
+
+  const auto t = umul(v, d[0]);
+
+  p += t[1];
+  if (p < t[1]) {
+    --v;
+    if (p >= d[1]) {
+      if (p > d[1] || t[0] >= d[0])
+        --v;
+    }
+  }
+  return v;
+}
+
+inline div_result<uint64_t>
+udivrem_2by1(uint128 u, uint64_t d, uint64_t v) noexcept {
+  auto q = umul(v, u[1]);
+  q = fast_add(q, u);
+
+  ++q[1];
+
+  auto r = u[0] - q[1] * d;
+
+  if (r > q[0]) {
+    --q[1];
+    r += d;
+  }
+
+  if (r >= d) {
+    ++q[1];
+    r -= d;
+  }
+
+  return {q[1], r};
+}
+
+inline div_result<uint64_t, uint128> udivrem_3by2(
+        uint64_t u2, uint64_t u1, uint64_t u0, uint128 d, uint64_t v) noexcept {
+  auto q = umul(v, u2);
+  q = fast_add(q, {u1, u2});
+
+  auto r1 = u1 - q[1] * d[1];
+
+  auto t = umul(d[0], q[1]);
+
+  auto r = uint128{u0, r1} - t - d;
+  r1 = r[1];
+
+  ++q[1];
+
+  if (r1 >= q[0]) {
+    --q[1];
+    r += d;
+  }
+
+  if (r >= d) {
+    ++q[1];
+    r -= d;
+  }
+
+  return {q[1], r};
+}
+
+inline div_result<uint128> udivrem(uint128 x, uint128 y) noexcept {
+  if (y[1] == 0) {
+            INTX_REQUIRE(y[0] != 0);  // Division by 0.
+
+    const auto lsh = clz(y[0]);
+    const auto rsh = (64 - lsh) % 64;
+    const auto rsh_mask = uint64_t{lsh == 0} - 1;
+
+    const auto yn = y[0] << lsh;
+    const auto xn_lo = x[0] << lsh;
+    const auto xn_hi = (x[1] << lsh) | ((x[0] >> rsh) & rsh_mask);
+    const auto xn_ex = (x[1] >> rsh) & rsh_mask;
+
+    const auto v = reciprocal_2by1(yn);
+    const auto res1 = udivrem_2by1({xn_hi, xn_ex}, yn, v);
+    const auto res2 = udivrem_2by1({xn_lo, res1.rem}, yn, v);
+    return {{res2.quot, res1.quot}, res2.rem >> lsh};
+  }
+
+  if (y[1] > x[1])
+    return {0, x};
+
+  const auto lsh = clz(y[1]);
+  if (lsh == 0) {
+    const auto q = unsigned{y[1] < x[1]} | unsigned{y[0] <= x[0]};
+    return {q, x - (q ? y : 0)};
+  }
+
+  const auto rsh = 64 - lsh;
+
+  const auto yn_lo = y[0] << lsh;
+  const auto yn_hi = (y[1] << lsh) | (y[0] >> rsh);
+  const auto xn_lo = x[0] << lsh;
+  const auto xn_hi = (x[1] << lsh) | (x[0] >> rsh);
+  const auto xn_ex = x[1] >> rsh;
+
+  const auto v = reciprocal_3by2({yn_lo, yn_hi});
+  const auto res = udivrem_3by2(xn_ex, xn_hi, xn_lo, {yn_lo, yn_hi}, v);
+
+  return {res.quot, res.rem >> lsh};
+}
+
+inline div_result<uint128> sdivrem(uint128 x, uint128 y) noexcept {
+  constexpr auto sign_mask = uint128{1} << 127;
+  const auto x_is_neg = (x & sign_mask) != 0;
+  const auto y_is_neg = (y & sign_mask) != 0;
+
+  const auto x_abs = x_is_neg ? -x : x;
+  const auto y_abs = y_is_neg ? -y : y;
+
+  const auto q_is_neg = x_is_neg ^ y_is_neg;
+
+  const auto res = udivrem(x_abs, y_abs);
+
+  return {q_is_neg ? -res.quot : res.quot, x_is_neg ? -res.rem : res.rem};
+}
+
+inline uint128 operator/(uint128 x, uint128 y) noexcept {
+  return udivrem(x, y).quot;
+}
+
+inline uint128 operator%(uint128 x, uint128 y) noexcept {
+  return udivrem(x, y).rem;
+}
+
+inline uint128& operator/=(uint128& x, uint128 y) noexcept {
+  return x = x / y;
+}
+
+inline uint128& operator%=(uint128& x, uint128 y) noexcept {
+  return x = x % y;
+}
+
+
+}  // namespace intx
+
+namespace std {
+template<unsigned N>
+struct numeric_limits<intx::uint<N>> {
+  using type = intx::uint<N>;
+
+  static constexpr bool is_specialized = true;
+  static constexpr bool is_integer = true;
+  static constexpr bool is_signed = false;
+  static constexpr bool is_exact = true;
+  static constexpr bool has_infinity = false;
+  static constexpr bool has_quiet_NaN = false;
+  static constexpr bool has_signaling_NaN = false;
+  static constexpr float_denorm_style has_denorm = denorm_absent;
+  static constexpr bool has_denorm_loss = false;
+  static constexpr float_round_style round_style = round_toward_zero;
+  static constexpr bool is_iec559 = false;
+  static constexpr bool is_bounded = true;
+  static constexpr bool is_modulo = true;
+  static constexpr int digits = CHAR_BIT * sizeof(type);
+  static constexpr int digits10 = int(0.3010299956639812 * digits);
+  static constexpr int max_digits10 = 0;
+  static constexpr int radix = 2;
+  static constexpr int min_exponent = 0;
+  static constexpr int min_exponent10 = 0;
+  static constexpr int max_exponent = 0;
+  static constexpr int max_exponent10 = 0;
+  static constexpr bool traps = std::numeric_limits<unsigned>::traps;
+  static constexpr bool tinyness_before = false;
+
+  static constexpr type min() noexcept { return 0; }
+
+  static constexpr type lowest() noexcept { return min(); }
+
+  static constexpr type max() noexcept { return ~type{0}; }
+
+  static constexpr type epsilon() noexcept { return 0; }
+
+  static constexpr type round_error() noexcept { return 0; }
+
+  static constexpr type infinity() noexcept { return 0; }
+
+  static constexpr type quiet_NaN() noexcept { return 0; }
+
+  static constexpr type signaling_NaN() noexcept { return 0; }
+
+  static constexpr type denorm_min() noexcept { return 0; }
+};
+}  // namespace std
+
+namespace intx {
+template<typename T>
+[[noreturn]] inline void throw_(const char* what) {
+#if __cpp_exceptions
+  throw T{what};
+#else
+  std::fputs(what, stderr);
+  std::abort();
+#endif
+}
+
+inline constexpr int from_dec_digit(char c) {
+  if (c < '0' || c > '9')
+    throw_<std::invalid_argument>("invalid digit");
+  return c - '0';
+}
+
+inline constexpr int from_hex_digit(char c) {
+  if (c >= 'a' && c <= 'f')
+    return c - ('a' - 10);
+  if (c >= 'A' && c <= 'F')
+    return c - ('A' - 10);
+  return from_dec_digit(c);
+}
+
+template<typename Int>
+inline constexpr Int from_string(const char* str) {
+  auto s = str;
+  auto x = Int{};
+  int num_digits = 0;
+
+  if (s[0] == '0' && s[1] == 'x') {
+    s += 2;
+    while (const auto c = *s++) {
+      if (++num_digits > int{sizeof(x) * 2})
+        throw_<std::out_of_range>(str);
+      x = (x << uint64_t{4}) | from_hex_digit(c);
+    }
+    return x;
+  }
+
+  while (const auto c = *s++) {
+    if (num_digits++ > std::numeric_limits<Int>::digits10)
+      throw_<std::out_of_range>(str);
+
+    const auto d = from_dec_digit(c);
+    x = x * Int{10} + d;
+    if (x < d)
+      throw_<std::out_of_range>(str);
+  }
+  return x;
+}
+
+template<typename Int>
+inline constexpr Int from_string(const std::string& s) {
+  return from_string<Int>(s.c_str());
+}
+
+inline constexpr uint128 operator ""_u128(const char* s) {
+  return from_string<uint128>(s);
+}
+
+template<unsigned N>
+inline std::string to_string(uint<N> x, int base = 10) {
+  if (base < 2 || base > 36)
+    throw_<std::invalid_argument>("invalid base");
+
+  if (x == 0)
+    return "0";
+
+  auto s = std::string{};
+  while (x != 0) {
+    // TODO: Use constexpr udivrem_1?
+    const auto res = udivrem(x, uint<N>{base});
+    const auto d = int(res.rem);
+    const auto c = d < 10 ? '0' + d : 'a' + d - 10;
+    s.push_back(char(c));
+    x = res.quot;
+  }
+  std::reverse(s.begin(), s.end());
+  return s;
+}
+
+template<unsigned N>
+inline std::string hex(uint<N> x) {
+  return to_string(x, 16);
+}
+}  // namespace intx
+
+namespace intx {
+template<unsigned N>
+struct uint {
+  using word_type = uint64_t;
+  static constexpr auto word_num_bits = sizeof(word_type) * 8;
+  static constexpr auto num_bits = N;
+  static constexpr auto num_words = num_bits / word_num_bits;
+
+  static_assert(N >= 2 * word_num_bits, "Number of bits must be at lest 128");
+  static_assert(N % word_num_bits == 0,
+                "Number of bits must be a multiply of 64");
+
+ private:
+  uint64_t words_[num_words]{};
+
+ public:
+  constexpr uint() noexcept = default;
+
+  /// Implicit converting constructor for any smaller uint type.
+  template<unsigned M, typename = typename std::enable_if_t<(M < N)>>
+  constexpr uint(const uint<M>& x) noexcept {
+    for (size_t i = 0; i < uint<M>::num_words; ++i)
+      words_[i] = x[i];
+  }
+
+  template<typename... T,
+          typename = std::enable_if_t<std::conjunction_v<std::is_convertible<T, uint64_t>...>>>
+  constexpr uint(T... v) noexcept : words_{static_cast<uint64_t>(v)...} {}
+
+  constexpr uint64_t& operator[](size_t i) noexcept { return words_[i]; }
+
+  constexpr const uint64_t&
+  operator[](size_t i) const noexcept { return words_[i]; }
+
+  constexpr explicit operator bool() const noexcept { return *this != uint{}; }
+
+  template<unsigned M, typename = typename std::enable_if_t<(M < N)>>
+  constexpr explicit operator uint<M>() const noexcept {
+    uint<M> r;
+    for (size_t i = 0; i < uint<M>::num_words; ++i)
+      r[i] = words_[i];
+    return r;
+  }
+
+  /// Explicit converting operator for all builtin integral types.
+  template<typename Int, typename = typename std::enable_if_t<std::is_integral_v<Int>>>
+  explicit operator Int() const noexcept {
+    static_assert(sizeof(Int) <= sizeof(uint64_t));
+    return static_cast<Int>(words_[0]);
+  }
+};
+
+using uint192 = uint<192>;
+using uint256 = uint<256>;
+using uint320 = uint<320>;
+using uint384 = uint<384>;
+using u5 = uint<512>;
+
+template<unsigned N>
+inline constexpr bool operator==(const uint<N>& x, const uint<N>& y) noexcept {
+  bool result = true;
+  for (size_t i = 0; i < uint<N>::num_words; ++i)
+    result &= (x[i] == y[i]);
+  return result;
+}
+
+template<unsigned N, typename T,
+        typename = typename std::enable_if<std::is_convertible<T, uint<N>>::value>::type>
+inline constexpr bool operator==(const uint<N>& x, const T& y) noexcept {
+  return x == uint<N>(y);
+}
+
+template<unsigned N, typename T,
+        typename = typename std::enable_if<std::is_convertible<T, uint<N>>::value>::type>
+inline constexpr bool operator==(const T& x, const uint<N>& y) noexcept {
+  return uint<N>(y) == x;
+}
+
+
+template<unsigned N>
+inline constexpr bool operator!=(const uint<N>& x, const uint<N>& y) noexcept {
+  return !(x == y);
+}
+
+template<unsigned N, typename T,
+        typename = typename std::enable_if<std::is_convertible<T, uint<N>>::value>::type>
+inline constexpr bool operator!=(const uint<N>& x, const T& y) noexcept {
+  return x != uint<N>(y);
+}
+
+template<unsigned N, typename T,
+        typename = typename std::enable_if<std::is_convertible<T, uint<N>>::value>::type>
+inline constexpr bool operator!=(const T& x, const uint<N>& y) noexcept {
+  return uint<N>(x) != y;
+}
+
+#if !defined(_MSC_VER) || _MSC_VER < 1916  // This kills MSVC 2017 compiler.
+
+inline constexpr bool operator<(const uint256& x, const uint256& y) noexcept {
+  const auto xhi = uint128{x[2], x[3]};
+  const auto xlo = uint128{x[0], x[1]};
+  const auto yhi = uint128{y[2], y[3]};
+  const auto ylo = uint128{y[0], y[1]};
+  return (xhi < yhi) | ((xhi == yhi) & (xlo < ylo));
+}
+
+#endif
+
+template<unsigned N>
+inline constexpr bool operator<(const uint<N>& x, const uint<N>& y) noexcept {
+  return sub_with_carry(x, y).carry;
+}
+
+template<unsigned N, typename T,
+        typename = typename std::enable_if<std::is_convertible<T, uint<N>>::value>::type>
+inline constexpr bool operator<(const uint<N>& x, const T& y) noexcept {
+  return x < uint<N>(y);
+}
+
+template<unsigned N, typename T,
+        typename = typename std::enable_if<std::is_convertible<T, uint<N>>::value>::type>
+inline constexpr bool operator<(const T& x, const uint<N>& y) noexcept {
+  return uint<N>(x) < y;
+}
+
+
+template<unsigned N>
+inline constexpr bool operator>(const uint<N>& x, const uint<N>& y) noexcept {
+  return y < x;
+}
+
+template<unsigned N, typename T,
+        typename = typename std::enable_if<std::is_convertible<T, uint<N>>::value>::type>
+inline constexpr bool operator>(const uint<N>& x, const T& y) noexcept {
+  return x > uint<N>(y);
+}
+
+template<unsigned N, typename T,
+        typename = typename std::enable_if<std::is_convertible<T, uint<N>>::value>::type>
+inline constexpr bool operator>(const T& x, const uint<N>& y) noexcept {
+  return uint<N>(x) > y;
+}
+
+
+template<unsigned N>
+inline constexpr bool operator>=(const uint<N>& x, const uint<N>& y) noexcept {
+  return !(x < y);
+}
+
+template<unsigned N, typename T,
+        typename = typename std::enable_if<std::is_convertible<T, uint<N>>::value>::type>
+inline constexpr bool operator>=(const uint<N>& x, const T& y) noexcept {
+  return x >= uint<N>(y);
+}
+
+template<unsigned N, typename T,
+        typename = typename std::enable_if<std::is_convertible<T, uint<N>>::value>::type>
+inline constexpr bool operator>=(const T& x, const uint<N>& y) noexcept {
+  return uint<N>(x) >= y;
+}
+
+
+template<unsigned N>
+inline constexpr bool operator<=(const uint<N>& x, const uint<N>& y) noexcept {
+  return !(y < x);
+}
+
+template<unsigned N, typename T,
+        typename = typename std::enable_if<std::is_convertible<T, uint<N>>::value>::type>
+inline constexpr bool operator<=(const uint<N>& x, const T& y) noexcept {
+  return x <= uint<N>(y);
+}
+
+template<unsigned N, typename T,
+        typename = typename std::enable_if<std::is_convertible<T, uint<N>>::value>::type>
+inline constexpr bool operator<=(const T& x, const uint<N>& y) noexcept {
+  return uint<N>(x) <= y;
+}
+
+template<unsigned N>
+inline constexpr bool slt(const uint<N>& x, const uint<N>& y) noexcept {
+  constexpr auto top_word_idx = uint<N>::num_words - 1;
+  const auto x_neg = static_cast<int64_t>(x[top_word_idx]) < 0;
+  const auto y_neg = static_cast<int64_t>(y[top_word_idx]) < 0;
+  return ((x_neg ^ y_neg) != 0) ? x_neg : x < y;
+}
+
+template<unsigned N>
+inline constexpr uint<N>
+operator|(const uint<N>& x, const uint<N>& y) noexcept {
+  uint<N> z;
+  for (size_t i = 0; i < uint<N>::num_words; ++i)
+    z[i] = x[i] | y[i];
+  return z;
+}
+
+template<unsigned N>
+inline constexpr uint<N>
+operator&(const uint<N>& x, const uint<N>& y) noexcept {
+  uint<N> z;
+  for (size_t i = 0; i < uint<N>::num_words; ++i)
+    z[i] = x[i] & y[i];
+  return z;
+}
+
+template<unsigned N>
+inline constexpr uint<N>
+operator^(const uint<N>& x, const uint<N>& y) noexcept {
+  uint<N> z;
+  for (size_t i = 0; i < uint<N>::num_words; ++i)
+    z[i] = x[i] ^ y[i];
+  return z;
+}
+
+template<unsigned N>
+inline constexpr uint<N> operator~(const uint<N>& x) noexcept {
+  uint<N> z;
+  for (size_t i = 0; i < uint<N>::num_words; ++i)
+    z[i] = ~x[i];
+  return z;
+}
+
+
+inline constexpr uint256 operator<<(const uint256& x, uint64_t shift) noexcept {
+  if (INTX_UNLIKELY(shift >= uint256::num_bits))
+    return 0;
+
+  constexpr auto num_bits = uint256::num_bits;
+  constexpr auto half_bits = num_bits / 2;
+
+  const auto xlo = uint128{x[0], x[1]};
+
+  if (shift < half_bits) {
+    const auto lo = xlo << shift;
+
+    const auto xhi = uint128{x[2], x[3]};
+
+    // Find the part moved from lo to hi.
+    // The shift right here can be invalid:
+    // for shift == 0 => rshift == half_bits.
+    // Split it into 2 valid shifts by (rshift - 1) and 1.
+    const auto rshift = half_bits - shift;
+    const auto lo_overflow = (xlo >> (rshift - 1)) >> 1;
+    const auto hi = (xhi << shift) | lo_overflow;
+    return {lo[0], lo[1], hi[0], hi[1]};
+  }
+
+  const auto hi = xlo << (shift - half_bits);
+  return {0, 0, hi[0], hi[1]};
+}
+
+template<unsigned N>
+inline constexpr uint<N> operator<<(const uint<N>& x, uint64_t shift) noexcept {
+  if (INTX_UNLIKELY(shift >= uint<N>::num_bits))
+    return 0;
+
+  constexpr auto word_bits = sizeof(uint64_t) * 8;
+
+  const auto s = shift % word_bits;
+  const auto skip = static_cast<size_t>(shift / word_bits);
+
+  uint<N> r;
+  uint64_t carry = 0;
+  for (size_t i = 0; i < (uint<N>::num_words - skip); ++i) {
+    r[i + skip] = (x[i] << s) | carry;
+    carry = (x[i] >> (word_bits - s - 1)) >> 1;
+  }
+  return r;
+}
+
+
+inline constexpr uint256 operator>>(const uint256& x, uint64_t shift) noexcept {
+  if (INTX_UNLIKELY(shift >= uint256::num_bits))
+    return 0;
+
+  constexpr auto num_bits = uint256::num_bits;
+  constexpr auto half_bits = num_bits / 2;
+
+  const auto xhi = uint128{x[2], x[3]};
+
+  if (shift < half_bits) {
+    const auto hi = xhi >> shift;
+
+    const auto xlo = uint128{x[0], x[1]};
+
+    // Find the part moved from hi to lo.
+    // The shift left here can be invalid:
+    // for shift == 0 => lshift == half_bits.
+    // Split it into 2 valid shifts by (lshift - 1) and 1.
+    const auto lshift = half_bits - shift;
+    const auto hi_overflow = (xhi << (lshift - 1)) << 1;
+    const auto lo = (xlo >> shift) | hi_overflow;
+    return {lo[0], lo[1], hi[0], hi[1]};
+  }
+
+  const auto lo = xhi >> (shift - half_bits);
+  return {lo[0], lo[1], 0, 0};
+}
+
+template<unsigned N>
+inline constexpr uint<N> operator>>(const uint<N>& x, uint64_t shift) noexcept {
+  if (INTX_UNLIKELY(shift >= uint<N>::num_bits))
+    return 0;
+
+  constexpr auto num_words = uint<N>::num_words;
+  constexpr auto word_bits = sizeof(uint64_t) * 8;
+
+  const auto s = shift % word_bits;
+  const auto skip = static_cast<size_t>(shift / word_bits);
+
+  uint<N> r;
+  uint64_t carry = 0;
+  for (size_t i = 0; i < (num_words - skip); ++i) {
+    r[num_words - 1 - i - skip] = (x[num_words - 1 - i] >> s) | carry;
+    carry = (x[num_words - 1 - i] << (word_bits - s - 1)) << 1;
+  }
+  return r;
+}
+
+template<unsigned N>
+inline constexpr uint<N>
+operator<<(const uint<N>& x, const uint<N>& shift) noexcept {
+  uint64_t high_words_fold = 0;
+  for (size_t i = 1; i < uint<N>::num_words; ++i)
+    high_words_fold |= shift[i];
+
+  if (INTX_UNLIKELY(high_words_fold != 0))
+    return 0;
+
+  return x << shift[0];
+}
+
+template<unsigned N>
+inline constexpr uint<N>
+operator>>(const uint<N>& x, const uint<N>& shift) noexcept {
+  uint64_t high_words_fold = 0;
+  for (size_t i = 1; i < uint<N>::num_words; ++i)
+    high_words_fold |= shift[i];
+
+  if (INTX_UNLIKELY(high_words_fold != 0))
+    return 0;
+
+  return x >> shift[0];
+}
+
+template<unsigned N, typename T,
+        typename = typename std::enable_if<std::is_convertible<T, uint<N>>::value>::type>
+inline constexpr uint<N> operator<<(const uint<N>& x, const T& shift) noexcept {
+  if (shift < T{sizeof(x) * 8})
+    return x << static_cast<uint64_t>(shift);
+  return 0;
+}
+
+template<unsigned N, typename T,
+        typename = typename std::enable_if<std::is_convertible<T, uint<N>>::value>::type>
+inline constexpr uint<N> operator>>(const uint<N>& x, const T& shift) noexcept {
+  if (shift < T{sizeof(x) * 8})
+    return x >> static_cast<uint64_t>(shift);
+  return 0;
+}
+
+template<unsigned N>
+inline constexpr uint<N>& operator>>=(uint<N>& x, uint64_t shift) noexcept {
+  return x = x >> shift;
+}
+
+
+inline constexpr uint64_t* as_words(uint128& x) noexcept {
+  return &x[0];
+}
+
+inline constexpr const uint64_t* as_words(const uint128& x) noexcept {
+  return &x[0];
+}
+
+template<unsigned N>
+inline constexpr uint64_t* as_words(uint<N>& x) noexcept {
+  return &x[0];
+}
+
+template<unsigned N>
+inline constexpr const uint64_t* as_words(const uint<N>& x) noexcept {
+  return &x[0];
+}
+
+template<unsigned N>
+inline uint8_t* as_bytes(uint<N>& x) noexcept {
+  return reinterpret_cast<uint8_t*>(as_words(x));
+}
+
+template<unsigned N>
+inline const uint8_t* as_bytes(const uint<N>& x) noexcept {
+  return reinterpret_cast<const uint8_t*>(as_words(x));
+}
+
+template<unsigned N>
+inline constexpr uint<N>
+operator+(const uint<N>& x, const uint<N>& y) noexcept {
+  return add_with_carry(x, y).value;
+}
+
+template<unsigned N>
+inline constexpr uint<N> operator-(const uint<N>& x) noexcept {
+  return ~x + uint<N>{1};
+}
+
+template<unsigned N>
+inline constexpr uint<N>
+operator-(const uint<N>& x, const uint<N>& y) noexcept {
+  return sub_with_carry(x, y).value;
+}
+
+template<unsigned N, typename T,
+        typename = typename std::enable_if<std::is_convertible<T, uint<N>>::value>::type>
+inline constexpr uint<N>& operator+=(uint<N>& x, const T& y) noexcept {
+  return x = x + y;
+}
+
+template<unsigned N, typename T,
+        typename = typename std::enable_if<std::is_convertible<T, uint<N>>::value>::type>
+inline constexpr uint<N>& operator-=(uint<N>& x, const T& y) noexcept {
+  return x = x - y;
+}
+
+template<unsigned N>
+inline constexpr uint<2 * N> umul(const uint<N>& x, const uint<N>& y) noexcept {
+  constexpr auto num_words = uint<N>::num_words;
+
+  uint<2 * N> p;
+  for (size_t j = 0; j < num_words; ++j) {
+    uint64_t k = 0;
+    for (size_t i = 0; i < num_words; ++i) {
+      const auto t = umul(x[i], y[j]) + p[i + j] + k;
+      p[i + j] = t[0];
+      k = t[1];
+    }
+    p[j + num_words] = k;
+  }
+  return p;
+}
+
+template<unsigned N>
+inline constexpr uint<N>
+operator*(const uint<N>& x, const uint<N>& y) noexcept {
+  constexpr auto num_words = uint<N>::num_words;
+
+  uint<N> p;
+  for (size_t j = 0; j < num_words; j++) {
+    uint64_t k = 0;
+    for (size_t i = 0; i < (num_words - j - 1); i++) {
+      const auto t = umul(x[i], y[j]) + p[i + j] + k;
+      p[i + j] = t[0];
+      k = t[1];
+    }
+    p[num_words - 1] += x[num_words - j - 1] * y[j] + k;
+  }
+  return p;
+}
+
+template<unsigned N, typename T,
+        typename = typename std::enable_if<std::is_convertible<T, uint<N>>::value>::type>
+inline constexpr uint<N>& operator*=(uint<N>& x, const T& y) noexcept {
+  return x = x * y;
+}
+
+template<unsigned N>
+inline constexpr uint<N> exp(uint<N> base, uint<N> exponent) noexcept {
+  auto result = uint<N>{1};
+  if (base == 2)
+    return result << exponent;
+
+  while (exponent != 0) {
+    if ((exponent & 1) != 0)
+      result *= base;
+    base *= base;
+    exponent >>= 1;
+  }
+  return result;
+}
+
+template<unsigned N>
+inline constexpr unsigned count_significant_words(const uint<N>& x) noexcept {
+  for (size_t i = uint<N>::num_words; i > 0; --i) {
+    if (x[i - 1] != 0)
+      return static_cast<unsigned>(i);
+  }
+  return 0;
+}
+
+inline constexpr unsigned count_significant_bytes(uint64_t x) noexcept {
+  return (64 - clz(x) + 7) / 8;
+}
+
+template<unsigned N>
+inline constexpr unsigned count_significant_bytes(const uint<N>& x) noexcept {
+  const auto w = count_significant_words(x);
+  return (w != 0) ? count_significant_bytes(x[w - 1]) + (w - 1) * 8 : 0;
+}
+
+template<unsigned N>
+inline constexpr unsigned clz(const uint<N>& x) noexcept {
+  constexpr unsigned num_words = uint<N>::num_words;
+  const auto s = count_significant_words(x);
+  if (s == 0)
+    return num_words * 64;
+  return clz(x[s - 1]) + (num_words - s) * 64;
+}
+
+namespace internal {
+inline constexpr unsigned clz_nonzero(uint64_t x) noexcept {
+          INTX_REQUIRE(x != 0);
+#ifdef _MSC_VER
+  return clz_generic(x);
+#else
+  return unsigned(__builtin_clzll(x));
+#endif
+}
+
+template<unsigned M, unsigned N>
+struct normalized_div_args {
+  uint<N> divisor;
+  uint<M + 64> numerator;
+  int num_divisor_words;
+  int num_numerator_words;
+  unsigned shift;
+};
+
+template<unsigned M, unsigned N>
+[[gnu::always_inline]] inline normalized_div_args<M, N> normalize(
+        const uint<M>& numerator, const uint<N>& denominator) noexcept {
+  // FIXME: Make the implementation type independent
+  static constexpr auto num_numerator_words = uint<M>::num_words;
+  static constexpr auto num_denominator_words = uint<N>::num_words;
+
+  auto* u = as_words(numerator);
+  auto* v = as_words(denominator);
+
+  normalized_div_args<M, N> na;
+  auto* un = as_words(na.numerator);
+  auto* vn = as_words(na.divisor);
+
+  auto& m = na.num_numerator_words;
+  for (m = num_numerator_words; m > 0 && u[m - 1] == 0; --m);
+
+  auto& n = na.num_divisor_words;
+  for (n = num_denominator_words; n > 0 && v[n - 1] == 0; --n);
+
+  na.shift = clz_nonzero(
+          v[n - 1]);  // Use clz_nonzero() to avoid clang analyzer's warning.
+  if (na.shift) {
+    for (int i = num_denominator_words - 1; i > 0; --i)
+      vn[i] = (v[i] << na.shift) | (v[i - 1] >> (64 - na.shift));
+    vn[0] = v[0] << na.shift;
+
+    un[num_numerator_words] = u[num_numerator_words - 1] >> (64 - na.shift);
+    for (int i = num_numerator_words - 1; i > 0; --i)
+      un[i] = (u[i] << na.shift) | (u[i - 1] >> (64 - na.shift));
+    un[0] = u[0] << na.shift;
+  } else {
+    na.numerator = numerator;
+    na.divisor = denominator;
+  }
+
+  // Skip the highest word of numerator if not significant.
+  if (un[m] != 0 || un[m - 1] >= vn[n - 1])
+    ++m;
+
+  return na;
+}
+
+inline uint64_t udivrem_by1(uint64_t u[], int len, uint64_t d) noexcept {
+          INTX_REQUIRE(len >= 2);
+
+  const auto reciprocal = reciprocal_2by1(d);
+
+  auto rem = u[len - 1];  // Set the top word as remainder.
+  u[len - 1] = 0;         // Reset the word being a part of the result quotient.
+
+  auto it = &u[len - 2];
+  do {
+    std::tie(*it, rem) = udivrem_2by1({*it, rem}, d, reciprocal);
+  } while (it-- != &u[0]);
+
+  return rem;
+}
+
+inline uint128 udivrem_by2(uint64_t u[], int len, uint128 d) noexcept {
+          INTX_REQUIRE(len >= 3);
+
+  const auto reciprocal = reciprocal_3by2(d);
+
+  auto rem = uint128{u[len - 2],
+                     u[len - 1]};  // Set the 2 top words as remainder.
+  u[len - 1] = u[len -
+                 2] = 0;  // Reset these words being a part of the result quotient.
+
+  auto it = &u[len - 3];
+  do {
+    std::tie(*it, rem) = udivrem_3by2(rem[1], rem[0], *it, d, reciprocal);
+  } while (it-- != &u[0]);
+
+  return rem;
+}
+
+inline bool
+add(uint64_t s[], const uint64_t x[], const uint64_t y[], int len) noexcept {
+  // OPT: Add MinLen template parameter and unroll first loop iterations.
+          INTX_REQUIRE(len >= 2);
+
+  bool carry = false;
+  for (int i = 0; i < len; ++i)
+    std::tie(s[i], carry) = add_with_carry(x[i], y[i], carry);
+  return carry;
+}
+
+inline uint64_t submul(
+        uint64_t r[], const uint64_t x[], const uint64_t y[], int len,
+        uint64_t multiplier) noexcept {
+  // OPT: Add MinLen template parameter and unroll first loop iterations.
+          INTX_REQUIRE(len >= 1);
+
+  uint64_t borrow = 0;
+  for (int i = 0; i < len; ++i) {
+    const auto s = sub_with_carry(x[i], borrow);
+    const auto p = umul(y[i], multiplier);
+    const auto t = sub_with_carry(s.value, p[0]);
+    r[i] = t.value;
+    borrow = p[1] + s.carry + t.carry;
+  }
+  return borrow;
+}
+
+inline void udivrem_knuth(
+        uint64_t q[], uint64_t u[], int ulen, const uint64_t d[],
+        int dlen) noexcept {
+          INTX_REQUIRE(dlen >= 3);
+          INTX_REQUIRE(ulen >= dlen);
+
+  const auto divisor = uint128{d[dlen - 2], d[dlen - 1]};
+  const auto reciprocal = reciprocal_3by2(divisor);
+  for (int j = ulen - dlen - 1; j >= 0; --j) {
+    const auto u2 = u[j + dlen];
+    const auto u1 = u[j + dlen - 1];
+    const auto u0 = u[j + dlen - 2];
+
+    uint64_t qhat;
+    if (INTX_UNLIKELY((uint128{u1, u2}) == divisor))  // Division overflows.
+    {
+      qhat = ~uint64_t{0};
+
+      u[j + dlen] = u2 - submul(&u[j], &u[j], d, dlen, qhat);
+    } else {
+      uint128 rhat;
+      std::tie(qhat, rhat) = udivrem_3by2(u2, u1, u0, divisor, reciprocal);
+
+      bool carry;
+      const auto overflow = submul(&u[j], &u[j], d, dlen - 2, qhat);
+      std::tie(u[j + dlen - 2], carry) = sub_with_carry(rhat[0], overflow);
+      std::tie(u[j + dlen - 1], carry) = sub_with_carry(rhat[1], carry);
+
+      if (INTX_UNLIKELY(carry)) {
+        --qhat;
+        u[j + dlen - 1] += divisor[1] + add(&u[j], &u[j], d, dlen - 1);
+      }
+    }
+
+    q[j] = qhat;  // Store quotient digit.
+  }
+}
+
+}  // namespace internal
+
+template<unsigned M, unsigned N>
+div_result<uint<M>, uint<N>>
+udivrem(const uint<M>& u, const uint<N>& v) noexcept {
+  auto na = internal::normalize(u, v);
+
+  if (na.num_numerator_words <= na.num_divisor_words)
+    return {0, static_cast<uint<N>>(u)};
+
+  if (na.num_divisor_words == 1) {
+    const auto r = internal::udivrem_by1(
+            as_words(na.numerator), na.num_numerator_words,
+            as_words(na.divisor)[0]);
+    return {static_cast<uint<M>>(na.numerator), r >> na.shift};
+  }
+
+  if (na.num_divisor_words == 2) {
+    const auto d = as_words(na.divisor);
+    const auto r =
+            internal::udivrem_by2(as_words(na.numerator),
+                                  na.num_numerator_words, {d[0], d[1]});
+    return {static_cast<uint<M>>(na.numerator), r >> na.shift};
+  }
+
+  auto un = as_words(na.numerator);  // Will be modified.
+
+  uint<M> q;
+  internal::udivrem_knuth(
+          as_words(q), &un[0], na.num_numerator_words, as_words(na.divisor),
+          na.num_divisor_words);
+
+  uint<N> r;
+  auto rw = as_words(r);
+  for (int i = 0; i < na.num_divisor_words - 1; ++i)
+    rw[i] = na.shift ? (un[i] >> na.shift) | (un[i + 1] << (64 - na.shift))
+                     : un[i];
+  rw[na.num_divisor_words - 1] = un[na.num_divisor_words - 1] >> na.shift;
+
+  return {q, r};
+}
+
+template<unsigned N>
+inline constexpr div_result<uint<N>>
+sdivrem(const uint<N>& u, const uint<N>& v) noexcept {
+  const auto sign_mask = uint<N>{1} << (sizeof(u) * 8 - 1);
+  auto u_is_neg = (u & sign_mask) != 0;
+  auto v_is_neg = (v & sign_mask) != 0;
+
+  auto u_abs = u_is_neg ? -u : u;
+  auto v_abs = v_is_neg ? -v : v;
+
+  auto q_is_neg = u_is_neg ^ v_is_neg;
+
+  auto res = udivrem(u_abs, v_abs);
+
+  return {q_is_neg ? -res.quot : res.quot, u_is_neg ? -res.rem : res.rem};
+}
+
+template<unsigned N>
+inline constexpr uint<N>
+operator/(const uint<N>& x, const uint<N>& y) noexcept {
+  return udivrem(x, y).quot;
+}
+
+template<unsigned N>
+inline constexpr uint<N>
+operator%(const uint<N>& x, const uint<N>& y) noexcept {
+  return udivrem(x, y).rem;
+}
+
+template<unsigned N, typename T,
+        typename = typename std::enable_if<std::is_convertible<T, uint<N>>::value>::type>
+inline constexpr uint<N>& operator/=(uint<N>& x, const T& y) noexcept {
+  return x = x / y;
+}
+
+template<unsigned N, typename T,
+        typename = typename std::enable_if<std::is_convertible<T, uint<N>>::value>::type>
+inline constexpr uint<N>& operator%=(uint<N>& x, const T& y) noexcept {
+  return x = x % y;
+}
+
+/// Barrett reduction modulo a fixed m (HAC 14.42). The reciprocal
+/// (b^(2k) - 1) / m, where b = 2^64 and m has k significant words, is computed
+/// once, so a modular product then costs two partial multiplications instead
+/// of a long division.
+template<unsigned N>
+class barrett_context {
+  static constexpr auto num_words = uint<N>::num_words;
+
+ public:
+  explicit barrett_context(const uint<N>& mod) noexcept
+          : mod_{mod}, k_{count_significant_words(mod)} {
+    INTX_REQUIRE(mod != 0);
+    // b^(2k) / m itself needs k + 2 words when m is a power of b. One less
+    // always fits in k + 1 and only costs one more correction step.
+    mu_ = static_cast<uint<N + 64>>(
+            ((uint<2 * N + 128>{1} << (128 * k_)) - 1) / uint<2 * N + 128>{mod});
+  }
+
+  const uint<N>& mod() const noexcept { return mod_; }
+
+  /// Returns x mod m for x < b^(2k), in particular for any product of two
+  /// residues.
+  uint<N> reduce(const uint<2 * N>& x) const noexcept {
+    // With a full-width modulus the loop bounds are constants.
+    if (k_ == num_words)
+      return reduce_words(x, num_words);
+    return reduce_words(x, k_);
+  }
+
+  /// Returns x * y mod m for x, y < m.
+  uint<N> mulmod(const uint<N>& x, const uint<N>& y) const noexcept {
+    return reduce(umul(x, y));
+  }
+
+  /// Returns x^2 mod m for x < m.
+  uint<N> sqrmod(const uint<N>& x) const noexcept { return mulmod(x, x); }
+
+  /// Returns base^exponent mod m for base < m.
+  uint<N> powmod(const uint<N>& base, const uint<N>& exponent) const noexcept {
+    auto result = reduce(uint<2 * N>{1});
+    for (auto i = N - clz(exponent); i > 0; --i) {
+      result = sqrmod(result);
+      if (((exponent[(i - 1) / 64] >> ((i - 1) % 64)) & 1) != 0)
+        result = mulmod(result, base);
+    }
+    return result;
+  }
+
+ private:
+  [[gnu::always_inline]] uint<N> reduce_words(
+          const uint<2 * N>& x, size_t k) const noexcept {
+    // q = (x / b^(k-1)) mu / b^(k+1) is below x / m by at most 3. Words of
+    // the product below k - 1 are skipped, which costs at most one more.
+    uint64_t q[2 * num_words + 2]{};
+    for (size_t i = 0; i <= k; ++i) {
+      uint64_t carry = 0;
+      for (size_t j = i + 1 < k ? k - 1 - i : 0; j <= k; ++j) {
+        const auto t = umul(x[k - 1 + i], mu_[j]) + q[i + j] + carry;
+        q[i + j] = t[0];
+        carry = t[1];
+      }
+      q[i + k + 1] = carry;
+    }
+
+    // r = x - q m mod b^(k+1).
+    uint64_t qm[num_words + 1]{};
+    for (size_t i = 0; i <= k; ++i) {
+      uint64_t carry = 0;
+      for (size_t j = 0; j < k && i + j <= k; ++j) {
+        const auto t = umul(q[k + 1 + i], mod_[j]) + qm[i + j] + carry;
+        qm[i + j] = t[0];
+        carry = t[1];
+      }
+      if (i == 0)
+        qm[k] = carry;
+    }
+    uint64_t r[num_words + 1]{};
+    bool borrow = false;
+    for (size_t i = 0; i <= k; ++i) {
+      const auto s = sub_with_carry(x[i], qm[i], borrow);
+      r[i] = s.value;
+      borrow = s.carry;
+    }
+
+    while (!less_than_mod(r, k)) {
+      borrow = false;
+      for (size_t i = 0; i <= k; ++i) {
+        const auto s = sub_with_carry(r[i], i < k ? mod_[i] : 0, borrow);
+        r[i] = s.value;
+        borrow = s.carry;
+      }
+    }
+    uint<N> result;
+    for (size_t i = 0; i < k; ++i)
+      result[i] = r[i];
+    return result;
+  }
+
+  bool less_than_mod(const uint64_t r[], size_t k) const noexcept {
+    if (r[k] != 0)
+      return false;
+    for (size_t i = k; i > 0; --i) {
+      if (r[i - 1] != mod_[i - 1])
+        return r[i - 1] < mod_[i - 1];
+    }
+    return false;
+  }
+
+  uint<N> mod_;
+  unsigned k_;
+  uint<N + 64> mu_;
+};
+
+template<unsigned N>
+inline constexpr uint<N> bswap(const uint<N>& x) noexcept {
+  constexpr auto num_words = uint<N>::num_words;
+  uint<N> z;
+  for (size_t i = 0; i < num_words; ++i)
+    z[num_words - 1 - i] = bswap(x[i]);
+  return z;
+}
+
+
+
+template<unsigned N, typename T,
+        typename = typename std::enable_if<std::is_convertible<T, uint<N>>::value>::type>
+inline constexpr uint<N> operator+(const uint<N>& x, const T& y) noexcept {
+  return x + uint<N>(y);
+}
+
+template<unsigned N, typename T,
+        typename = typename std::enable_if<std::is_convertible<T, uint<N>>::value>::type>
+inline constexpr uint<N> operator+(const T& x, const uint<N>& y) noexcept {
+  return uint<N>(x) + y;
+}
+
+template<unsigned N, typename T,
+        typename = typename std::enable_if<std::is_convertible<T, uint<N>>::value>::type>
+inline constexpr uint<N> operator-(const uint<N>& x, const T& y) noexcept {
+  return x - uint<N>(y);
+}
+
+template<unsigned N, typename T,
+        typename = typename std::enable_if<std::is_convertible<T, uint<N>>::value>::type>
+inline constexpr uint<N> operator-(const T& x, const uint<N>& y) noexcept {
+  return uint<N>(x) - y;
+}
+
+template<unsigned N, typename T,
+        typename = typename std::enable_if<std::is_convertible<T, uint<N>>::value>::type>
+inline constexpr uint<N> operator*(const uint<N>& x, const T& y) noexcept {
+  return x * uint<N>(y);
+}
+
+template<unsigned N, typename T,
+        typename = typename std::enable_if<std::is_convertible<T, uint<N>>::value>::type>
+inline constexpr uint<N> operator*(const T& x, const uint<N>& y) noexcept {
+  return uint<N>(x) * y;
+}
+
+template<unsigned N, typename T,
+        typename = typename std::enable_if<std::is_convertible<T, uint<N>>::value>::type>
+inline constexpr uint<N> operator/(const uint<N>& x, const T& y) noexcept {
+  return x / uint<N>(y);
+}
+
+template<unsigned N, typename T,
+        typename = typename std::enable_if<std::is_convertible<T, uint<N>>::value>::type>
+inline constexpr uint<N> operator/(const T& x, const uint<N>& y) noexcept {
+  return uint<N>(x) / y;
+}
+
+template<unsigned N, typename T,
+        typename = typename std::enable_if<std::is_convertible<T, uint<N>>::value>::type>
+inline constexpr uint<N> operator%(const uint<N>& x, const T& y) noexcept {
+  return x % uint<N>(y);
+}
+
+template<unsigned N, typename T,
+        typename = typename std::enable_if<std::is_convertible<T, uint<N>>::value>::type>
+inline constexpr uint<N> operator%(const T& x, const uint<N>& y) noexcept {
+  return uint<N>(x) % y;
+}
+
+template<unsigned N, typename T,
+        typename = typename std::enable_if<std::is_convertible<T, uint<N>>::value>::type>
+inline constexpr uint<N> operator|(const uint<N>& x, const T& y) noexcept {
+  return x | uint<N>(y);
+}
+
+template<unsigned N, typename T,
+        typename = typename std::enable_if<std::is_convertible<T, uint<N>>::value>::type>
+inline constexpr uint<N> operator|(const T& x, const uint<N>& y) noexcept {
+  return uint<N>(x) | y;
+}
+
+template<unsigned N, typename T,
+        typename = typename std::enable_if<std::is_convertible<T, uint<N>>::value>::type>
+inline constexpr uint<N> operator&(const uint<N>& x, const T& y) noexcept {
+  return x & uint<N>(y);
+}
+
+template<unsigned N, typename T,
+        typename = typename std::enable_if<std::is_convertible<T, uint<N>>::value>::type>
+inline constexpr uint<N> operator&(const T& x, const uint<N>& y) noexcept {
+  return uint<N>(x) & y;
+}
+
+template<unsigned N, typename T,
+        typename = typename std::enable_if<std::is_convertible<T, uint<N>>::value>::type>
+inline constexpr uint<N> operator^(const uint<N>& x, const T& y) noexcept {
+  return x ^ uint<N>(y);
+}
+
+template<unsigned N, typename T,
+        typename = typename std::enable_if<std::is_convertible<T, uint<N>>::value>::type>
+inline constexpr uint<N> operator^(const T& x, const uint<N>& y) noexcept {
+  return uint<N>(x) ^ y;
+}
+
+template<unsigned N, typename T,
+        typename = typename std::enable_if<std::is_convertible<T, uint<N>>::value>::type>
+inline constexpr uint<N>& operator|=(uint<N>& x, const T& y) noexcept {
+  return x = x | y;
+}
+
+template<unsigned N, typename T,
+        typename = typename std::enable_if<std::is_convertible<T, uint<N>>::value>::type>
+inline constexpr uint<N>& operator&=(uint<N>& x, const T& y) noexcept {
+  return x = x & y;
+}
+
+template<unsigned N, typename T,
+        typename = typename std::enable_if<std::is_convertible<T, uint<N>>::value>::type>
+inline constexpr uint<N>& operator^=(uint<N>& x, const T& y) noexcept {
+  return x = x ^ y;
+}
+
+template<unsigned N, typename T,
+        typename = typename std::enable_if<std::is_convertible<T, uint<N>>::value>::type>
+inline constexpr uint<N>& operator<<=(uint<N>& x, const T& y) noexcept {
+  return x = x << y;
+}
+
+template<unsigned N, typename T,
+        typename = typename std::enable_if<std::is_convertible<T, uint<N>>::value>::type>
+inline constexpr uint<N>& operator>>=(uint<N>& x, const T& y) noexcept {
+  return x = x >> y;
+}
+
+
+inline uint256
+addmod(const uint256& x, const uint256& y, const uint256& mod) noexcept {
+  const auto s = add_with_carry(x, y);
+  uint<256 + 64> n = s.value;
+  n[4] = s.carry;
+  return udivrem(n, mod).rem;
+}
+
+inline uint256
+mulmod(const uint256& x, const uint256& y, const uint256& mod) noexcept {
+  return udivrem(umul(x, y), mod).rem;
+}
+
+
+inline constexpr uint256 operator "" _u256(const char* s) noexcept {
+  return from_string<uint256>(s);
+}
+
+inline constexpr u5 operator "" _u512(const char* s) noexcept {
+  return from_string<u5>(s);
+}
+
+namespace le  // Conversions to/from LE bytes.
+{
+template<typename IntT, unsigned M>
+inline IntT load(const uint8_t (& bytes)[M]) noexcept {
+  static_assert(M == IntT::num_bits / 8,
+                "the size of source bytes must match the size of the destination uint");
+  auto x = IntT{};
+  std::memcpy(&x, bytes, sizeof(x));
+  return x;
+}
+
+template<unsigned N>
+inline void store(uint8_t (& dst)[N / 8], const intx::uint<N>& x) noexcept {
+  std::memcpy(dst, &x, sizeof(x));
+}
+
+}  // namespace le
+
+
+namespace be  // Conversions to/from BE bytes.
+{
+template<typename IntT, unsigned M>
+inline IntT load(const uint8_t (& bytes)[M]) noexcept {
+  static_assert(M <= IntT::num_bits / 8,
+                "the size of source bytes must not exceed the size of the destination uint");
+  auto x = IntT{};
+  std::memcpy(&as_bytes(x)[IntT::num_bits / 8 - M], bytes, M);
+  return bswap(x);
+}
+
+template<typename IntT, typename T>
+inline IntT load(const T& t) noexcept {
+  return load<IntT>(t.bytes);
+}
+
+template<unsigned N>
+inline void store(uint8_t (& dst)[N / 8], const intx::uint<N>& x) noexcept {
+  const auto d = bswap(x);
+  std::memcpy(dst, &d, sizeof(d));
+}
+
+template<typename T, unsigned N>
+inline T store(const intx::uint<N>& x) noexcept {
+  T r{};
+  store(r.bytes, x);
+  return r;
+}
+
+template<unsigned M, unsigned N>
+inline void trunc(uint8_t (& dst)[M], const intx::uint<N>& x) noexcept {
+  static_assert(M < N / 8, "destination must be smaller than the source value");
+  const auto d = bswap(x);
+  const auto b = as_bytes(d);
+  std::memcpy(dst, &b[sizeof(d) - M], M);
+}
+
+template<typename T, unsigned N>
+inline T trunc(const intx::uint<N>& x) noexcept {
+  T r{};
+  trunc(r.bytes, x);
+  return r;
+}
+
+namespace unsafe {
+template<typename IntT>
+inline IntT load(const uint8_t* bytes) noexcept {
+  auto x = IntT{};
+  std::memcpy(&x, bytes, sizeof(x));
+  return bswap(x);
+}
+
+template<unsigned N>
+inline void store(uint8_t* dst, const intx::uint<N>& x) noexcept {
+  const auto d = bswap(x);
+  std::memcpy(dst, &d, sizeof(d));
+}
+}  // namespace unsafe
+
+}  // namespace be
+
+}  // namespace intx
+
+namespace math {
+
+class Number {
+ public:
+  Number(uint64_t base, std::vector<uint64_t> digits) : base_(base),
+                                                        digits_(std::move(
+                                                                digits)) {}
+
+  Number& operator+=(uint64_t num) {
+    digits_[0] += num;
+    Normalize();
+    return *this;
+  }
+
+  Number& operator*=(uint64_t num) {
+    uint64_t remainder = 0;
+    for (size_t i = 0; i < digits_.size(); ++i) {
+      digits_[i] *= num;
+      digits_[i] += remainder;
+      remainder = Split(i);
+    }
+    digits_.push_back(remainder);
+    Normalize();
+    return *this;
+  }
+
+  [[nodiscard]] size_t Size() const {
+    return digits_.size();
+  }
+
+  [[nodiscard]] uint64_t Base() const {
+    return base_;
+  }
+
+  [[nodiscard]] uint64_t GetDigit(size_t i) const {
+    return digits_[i];
+  }
+
+ private:
+  void Normalize() {
+    for (size_t i = 0; i < digits_.size(); ++i) {
+      uint64_t remainder = Split(i);
+      if (remainder == 0) {
+        continue;
+      }
+      if (i + 1 == digits_.size()) {
+        digits_.push_back(remainder);
+      } else {
+        digits_[i + 1] += remainder;
+      }
+    }
+    while (digits_.size() > 1 && digits_.back() == 0) {
+      digits_.pop_back();
+    }
+  }
+
+  uint64_t Split(size_t i) {
+    uint64_t remainder = digits_[i] / base_;
+    digits_[i] %= base_;
+    return remainder;
+  }
+
+  uint64_t base_;
+  std::vector<uint64_t> digits_;
+};
+
+using intx::operator ""_u256;
+using intx::operator ""_u512;
+
+using int128 = __int128;
+using uint128 = unsigned __int128;
+
+const int64_t kLimbMask62 = (int64_t{1} << 62) - 1;
+
+// Transition matrix of 62 divsteps: it maps (f, g) to
+// ((u f + v g) / 2^62, (q f + r g) / 2^62).
+struct DivstepMatrix {
+  int64_t u;
+  int64_t v;
+  int64_t q;
+  int64_t r;
+};
+
+// Runs 62 divsteps on the low bits of f and g, skipping runs of zero bits of
+// g at once. eta is minus the delta of the Bernstein-Yang paper.
+int64_t Divsteps62(int64_t eta, uint64_t f, uint64_t g,
+                   DivstepMatrix& matrix) {
+  uint64_t u = 1;
+  uint64_t v = 0;
+  uint64_t q = 0;
+  uint64_t r = 1;
+  int i = 62;
+  while (true) {
+    int zeros = __builtin_ctzll(g | (UINT64_MAX << i));
+    g >>= zeros;
+    u <<= zeros;
+    v <<= zeros;
+    eta -= zeros;
+    i -= zeros;
+    if (i == 0) {
+      break;
+    }
+    uint64_t w;
+    if (eta < 0) {
+      eta = -eta;
+      uint64_t tmp = f;
+      f = g;
+      g = -tmp;
+      tmp = u;
+      u = q;
+      q = -tmp;
+      tmp = v;
+      v = r;
+      r = -tmp;
+      int limit = std::min(static_cast<int>(eta) + 1, i);
+      uint64_t mask = (UINT64_MAX >> (64 - limit)) & 63;
+      w = (f * g * (f * f - 2)) & mask;
+    } else {
+      int limit = std::min(static_cast<int>(eta) + 1, i);
+      uint64_t mask = (UINT64_MAX >> (64 - limit)) & 15;
+      w = f + (((f + 1) & 4) << 1);
+      w = (-w * g) & mask;
+    }
+    g += f * w;
+    q += u * w;
+    r += v * w;
+  }
+  matrix = {static_cast<int64_t>(u), static_cast<int64_t>(v),
+            static_cast<int64_t>(q), static_cast<int64_t>(r)};
+  return eta;
+}
+
+// Modular inversion by Bernstein-Yang divsteps (safegcd) over W-word numbers.
+// Values are kept in L signed 62-bit limbs: every limb but the top one is in
+// [0, 2^62), the top one carries the sign.
+template<size_t W>
+class SafeGcd {
+ public:
+  static constexpr size_t kLimbs = 64 * W / 62 + 1;
+  using Limbs = std::array<int64_t, kLimbs>;
+
+  // Writes a^-1 modulo an odd mod into result, or 0 for a = 0. Expects
+  // gcd(a, mod) = 1.
+  static void Inverse(const uint64_t* a, const uint64_t* mod,
+                      uint64_t* result) {
+    Limbs modulus = ToLimbs(mod);
+    uint64_t mod_inv = mod[0];
+    for (size_t i = 0; i < 5; ++i) {
+      mod_inv *= 2 - mod[0] * mod_inv;
+    }
+    mod_inv &= kLimbMask62;
+
+    // Invariants: d * a = f and e * a = g modulo mod.
+    Limbs d{};
+    Limbs e{};
+    e[0] = 1;
+    Limbs f = modulus;
+    Limbs g = ToLimbs(a);
+    size_t len = kLimbs;
+    int64_t eta = -1;
+    while (true) {
+      DivstepMatrix matrix{};
+      eta = Divsteps62(eta, f[0], g[0], matrix);
+      UpdateDe(d, e, matrix, modulus, mod_inv);
+      UpdateFg(len, f, g, matrix);
+      if (g[0] == 0) {
+        int64_t rest = 0;
+        for (size_t i = 1; i < len; ++i) {
+          rest |= g[i];
+        }
+        if (rest == 0) {
+          break;
+        }
+      }
+      // Drop the top limb once both f and g fit into one limb less.
+      int64_t f_top = f[len - 1];
+      int64_t g_top = g[len - 1];
+      if (len > 1 && (f_top ^ (f_top >> 63)) == 0 &&
+          (g_top ^ (g_top >> 63)) == 0) {
+        f[len - 2] |= static_cast<int64_t>(static_cast<uint64_t>(f_top) << 62);
+        g[len - 2] |= static_cast<int64_t>(static_cast<uint64_t>(g_top) << 62);
+        --len;
+      }
+    }
+
+    // Now f = +-1, so the inverse is +-d, which lies in (-2 mod, mod).
+    if (f[len - 1] < 0) {
+      for (int64_t& limb : d) {
+        limb = -limb;
+      }
+      Carry(d);
+    }
+    while (d[kLimbs - 1] < 0) {
+      for (size_t i = 0; i < kLimbs; ++i) {
+        d[i] += modulus[i];
+      }
+      Carry(d);
+    }
+    while (!Less(d, modulus)) {
+      for (size_t i = 0; i < kLimbs; ++i) {
+        d[i] -= modulus[i];
+      }
+      Carry(d);
+    }
+    FromLimbs(d, result);
+  }
+
+ private:
+  static Limbs ToLimbs(const uint64_t* words) {
+    Limbs limbs{};
+    for (size_t i = 0; i < kLimbs; ++i) {
+      size_t word = 62 * i / 64;
+      size_t shift = 62 * i % 64;
+      uint64_t value = 0;
+      if (word < W) {
+        value = words[word] >> shift;
+        if (shift > 2 && word + 1 < W) {
+          value |= words[word + 1] << (64 - shift);
+        }
+      }
+      limbs[i] = static_cast<int64_t>(value) & kLimbMask62;
+    }
+    return limbs;
+  }
+
+  // Expects a carried value in [0, 2^(64 W)).
+  static void FromLimbs(const Limbs& limbs, uint64_t* words) {
+    std::fill(words, words + W, 0);
+    for (size_t i = 0; i < kLimbs; ++i) {
+      size_t word = 62 * i / 64;
+      size_t shift = 62 * i % 64;
+      auto limb = static_cast<uint64_t>(limbs[i]);
+      if (word < W) {
+        words[word] |= limb << shift;
+        if (shift > 2 && word + 1 < W) {
+          words[word + 1] |= limb >> (64 - shift);
+        }
+      }
+    }
+  }
+
+  static void Carry(Limbs& limbs) {
+    for (size_t i = 0; i + 1 < kLimbs; ++i) {
+      limbs[i + 1] += limbs[i] >> 62;
+      limbs[i] &= kLimbMask62;
+    }
+  }
+
+  static bool Less(const Limbs& x, const Limbs& y) {
+    for (size_t i = kLimbs; i > 0; --i) {
+      if (x[i - 1] != y[i - 1]) {
+        return x[i - 1] < y[i - 1];
+      }
+    }
+    return false;
+  }
+
+  // Applies the matrix to (d, e) and divides by 2^62 modulo mod, adding the
+  // multiple of mod that clears the low 62 bits. Keeps both in (-2 mod, mod).
+  static void UpdateDe(Limbs& d, Limbs& e, const DivstepMatrix& matrix,
+                       const Limbs& modulus, uint64_t mod_inv) {
+    int64_t d_sign = d[kLimbs - 1] >> 63;
+    int64_t e_sign = e[kLimbs - 1] >> 63;
+    int64_t md = (matrix.u & d_sign) + (matrix.v & e_sign);
+    int64_t me = (matrix.q & d_sign) + (matrix.r & e_sign);
+    int128 cd = static_cast<int128>(matrix.u) * d[0] +
+                static_cast<int128>(matrix.v) * e[0];
+    int128 ce = static_cast<int128>(matrix.q) * d[0] +
+                static_cast<int128>(matrix.r) * e[0];
+    md -= static_cast<int64_t>((mod_inv * static_cast<uint64_t>(cd) +
+                                static_cast<uint64_t>(md)) & kLimbMask62);
+    me -= static_cast<int64_t>((mod_inv * static_cast<uint64_t>(ce) +
+                                static_cast<uint64_t>(me)) & kLimbMask62);
+    cd += static_cast<int128>(modulus[0]) * md;
+    ce += static_cast<int128>(modulus[0]) * me;
+    cd >>= 62;
+    ce >>= 62;
+    for (size_t i = 1; i < kLimbs; ++i) {
+      cd += static_cast<int128>(matrix.u) * d[i] +
+            static_cast<int128>(matrix.v) * e[i] +
+            static_cast<int128>(modulus[i]) * md;
+      ce += static_cast<int128>(matrix.q) * d[i] +
+            static_cast<int128>(matrix.r) * e[i] +
+            static_cast<int128>(modulus[i]) * me;
+      d[i - 1] = static_cast<int64_t>(cd) & kLimbMask62;
+      e[i - 1] = static_cast<int64_t>(ce) & kLimbMask62;
+      cd >>= 62;
+      ce >>= 62;
+    }
+    d[kLimbs - 1] = static_cast<int64_t>(cd);
+    e[kLimbs - 1] = static_cast<int64_t>(ce);
+  }
+
+  // Applies the matrix to the first len limbs of (f, g); the low 62 bits of
+  // the products are zero and get shifted out.
+  static void UpdateFg(size_t len, Limbs& f, Limbs& g,
+                       const DivstepMatrix& matrix) {
+    int128 cf = static_cast<int128>(matrix.u) * f[0] +
+                static_cast<int128>(matrix.v) * g[0];
+    int128 cg = static_cast<int128>(matrix.q) * f[0] +
+                static_cast<int128>(matrix.r) * g[0];
+    cf >>= 62;
+    cg >>= 62;
+    for (size_t i = 1; i < len; ++i) {
+      cf += static_cast<int128>(matrix.u) * f[i] +
+            static_cast<int128>(matrix.v) * g[i];
+      cg += static_cast<int128>(matrix.q) * f[i] +
+            static_cast<int128>(matrix.r) * g[i];
+      f[i - 1] = static_cast<int64_t>(cf) & kLimbMask62;
+      g[i - 1] = static_cast<int64_t>(cg) & kLimbMask62;
+      cf >>= 62;
+      cg >>= 62;
+    }
+    f[len - 1] = static_cast<int64_t>(cf);
+    g[len - 1] = static_cast<int64_t>(cg);
+  }
+};
+
+template<unsigned N>
+intx::uint<N> InverseMod(const intx::uint<N>& a, const intx::uint<N>& mod) {
+  intx::uint<N> result;
+  SafeGcd<N / 64>::Inverse(&a[0], &mod[0], &result[0]);
+  return result;
+}
+
+// Element of the prime field described by Params, kept fully reduced in
+// Params::kWords 64-bit limbs. Params supplies the modulus and the reduction
+// of a double-width product, so each curve's field gets its own reduction at
+// compile time while the rest of the arithmetic is shared.
+template<typename Params>
+class PrimeField {
+ public:
+  static constexpr size_t kWords = Params::kWords;
+  using Uint = intx::uint<64 * kWords>;
+  static constexpr Uint kModulus = Params::kModulus;
+
+  PrimeField() = default;
+
+  // Expects value < p.
+  static constexpr PrimeField FromReduced(const Uint& value) {
+    PrimeField result;
+    result.value_ = value;
+    return result;
+  }
+
+  explicit PrimeField(uint64_t value) : value_(value) {}
+
+  explicit PrimeField(const intx::u5& value)
+          : value_(Barrett().reduce(intx::uint<128 * kWords>(value))) {}
+
+  [[nodiscard]] const Uint& Value() const {
+    return value_;
+  }
+
+  [[nodiscard]] intx::u5 ToU5() const {
+    return value_;
+  }
+
+  [[nodiscard]] bool IsZero() const {
+    return value_ == 0;
+  }
+
+  [[nodiscard]] bool IsOdd() const {
+    return (value_[0] & 1) != 0;
+  }
+
+  friend bool operator==(const PrimeField& x, const PrimeField& y) {
+    return x.value_ == y.value_;
+  }
+
+  friend bool operator!=(const PrimeField& x, const PrimeField& y) {
+    return !(x == y);
+  }
+
+  friend PrimeField operator+(const PrimeField& x, const PrimeField& y) {
+    PrimeField result;
+    uint64_t carry = AddLimbs(x.value_, y.value_, result.value_);
+    if (carry != 0 || result.value_ >= kModulus) {
+      SubLimbs(result.value_, kModulus, result.value_);
+    }
+    return result;
+  }
+
+  friend PrimeField operator-(const PrimeField& x, const PrimeField& y) {
+    PrimeField result;
+    if (SubLimbs(x.value_, y.value_, result.value_) != 0) {
+      AddLimbs(result.value_, kModulus, result.value_);
+    }
+    return result;
+  }
+
+  friend PrimeField operator*(const PrimeField& x, const PrimeField& y) {
+    uint64_t product[2 * kWords] = {};
+    for (size_t i = 0; i < kWords; ++i) {
+      uint64_t carry = 0;
+      for (size_t j = 0; j < kWords; ++j) {
+        uint128 current = static_cast<uint128>(x.value_[i]) * y.value_[j] +
+                          product[i + j] + carry;
+        product[i + j] = static_cast<uint64_t>(current);
+        carry = static_cast<uint64_t>(current >> 64);
+      }
+      product[i + kWords] = carry;
+    }
+    PrimeField result;
+    int64_t carry = Params::Reduce(product, result.value_);
+    while (carry < 0) {
+      carry += static_cast<int64_t>(
+              AddLimbs(result.value_, kModulus, result.value_));
+    }
+    while (carry > 0 || result.value_ >= kModulus) {
+      carry -= static_cast<int64_t>(
+              SubLimbs(result.value_, kModulus, result.value_));
+    }
+    return result;
+  }
+
+  [[nodiscard]] PrimeField Square() const {
+    return *this * *this;
+  }
+
+  [[nodiscard]] PrimeField Pow(const Uint& exponent) const {
+    PrimeField result(1);
+    for (size_t i = 64 * kWords; i > 0; --i) {
+      result = result.Square();
+      if (((exponent[(i - 1) / 64] >> ((i - 1) % 64)) & 1) != 0) {
+        result = result * *this;
+      }
+    }
+    return result;
+  }
+
+  // Returns 0 for zero.
+  [[nodiscard]] PrimeField Inverse() const {
+    PrimeField result;
+    result.value_ = InverseMod(value_, kModulus);
+    return result;
+  }
+
+ private:
+  static uint64_t AddLimbs(const Uint& x, const Uint& y, Uint& result) {
+    uint64_t carry = 0;
+    for (size_t i = 0; i < kWords; ++i) {
+      uint128 sum = static_cast<uint128>(x[i]) + y[i] + carry;
+      result[i] = static_cast<uint64_t>(sum);
+      carry = static_cast<uint64_t>(sum >> 64);
+    }
+    return carry;
+  }
+
+  static uint64_t SubLimbs(const Uint& x, const Uint& y, Uint& result) {
+    uint64_t borrow = 0;
+    for (size_t i = 0; i < kWords; ++i) {
+      uint128 difference = static_cast<uint128>(x[i]) - y[i] - borrow;
+      result[i] = static_cast<uint64_t>(difference);
+      borrow = static_cast<uint64_t>(difference >> 64) & 1;
+    }
+    return borrow;
+  }
+
+  // Reduces parsed numbers without a long division.
+  static const intx::barrett_context<64 * kWords>& Barrett() {
+    static const intx::barrett_context<64 * kWords> context(kModulus);
+    return context;
+  }
+
+  Uint value_;
+};
+
+// Field parameters. Reduce(product, result) stores in result a value that,
+// with the returned signed carry above its top word, is congruent to the
+// double-width product. PrimeField then brings it below p.
+
+// p = 2^256 - 2^224 + 2^192 + 2^96 - 1 is a generalized Mersenne prime, so
+// products are reduced with the Solinas identities (FIPS 186-4, D.2.3)
+// instead of a division.
+struct P256FieldParams {
+  static constexpr size_t kWords = 4;
+  static constexpr intx::uint256 kModulus{0xffffffffffffffff,
+                                          0x00000000ffffffff, 0,
+                                          0xffffffff00000001};
+
+  // Splits the product into 32-bit words c0..c15 and sums
+  // s1 + 2 s2 + 2 s3 + s4 + s5 - s6 - s7 - s8 - s9.
+  static int64_t Reduce(const uint64_t (&product)[8], intx::uint256& result) {
+    int64_t c[16];
+    for (size_t i = 0; i < 8; ++i) {
+      c[2 * i] = static_cast<int64_t>(product[i] & 0xffffffff);
+      c[2 * i + 1] = static_cast<int64_t>(product[i] >> 32);
+    }
+    int64_t words[8] = {
+            c[0] + c[8] + c[9] - c[11] - c[12] - c[13] - c[14],
+            c[1] + c[9] + c[10] - c[12] - c[13] - c[14] - c[15],
+            c[2] + c[10] + c[11] - c[13] - c[14] - c[15],
+            c[3] + 2 * c[11] + 2 * c[12] + c[13] - c[15] - c[8] - c[9],
+            c[4] + 2 * c[12] + 2 * c[13] + c[14] - c[9] - c[10],
+            c[5] + 2 * c[13] + 2 * c[14] + c[15] - c[10] - c[11],
+            c[6] + 3 * c[14] + 2 * c[15] + c[13] - c[8] - c[9],
+            c[7] + 3 * c[15] + c[8] - c[10] - c[11] - c[12] - c[13],
+    };
+    result = 0;
+    int64_t carry = 0;
+    for (size_t i = 0; i < 8; ++i) {
+      carry += words[i];
+      uint64_t word = static_cast<uint64_t>(carry) & 0xffffffff;
+      result[i / 2] |= word << (32 * (i % 2));
+      carry >>= 32;
+    }
+    return carry;
+  }
+};
+
+using P256Field = PrimeField<P256FieldParams>;
+
+// Curve registry: y^2 = x^3 + a x + b over Field, with generator (kGx, kGy)
+// of order kGroupSize. Points refer to these parameters instead of carrying
+// their own copies, and kAForm lets doubling drop the multiplication by a at
+// compile time.
+enum class CoefficientA {
+  kMinusThree,
+  kOther,
+};
+
+// NIST P-256.
+struct P256 {
+  using Field = P256Field;
+  using Scalar = intx::uint256;
+  static constexpr CoefficientA kAForm = CoefficientA::kMinusThree;
+  static constexpr Field kA = Field::FromReduced(Field::kModulus - 3);
+  static constexpr Field kB = Field::FromReduced(
+          41058363725152142129326129780047268409114441015993725554835256314039467401291_u256);
+  static constexpr Field kGx = Field::FromReduced(
+          48439561293906451759052585252797914202762949526041747995844080717082404635286_u256);
+  static constexpr Field kGy = Field::FromReduced(
+          36134250956749795798585127919587881956611106672985015071877198253568414405109_u256);
+  static constexpr Scalar kGroupSize =
+          115792089210356248762697446949407573529996955224135760342422259061068512044369_u256;
+};
+
+template<typename Curve>
+class BasicCurvePoint {
+ public:
+  using Field = typename Curve::Field;
+
+  BasicCurvePoint() : inf_(true) {}
+
+  BasicCurvePoint(Field x, Field y)
+          : inf_(false),
+            x_(x),
+            y_(y) {}
+
+  [[nodiscard]] bool IsInf() const {
+    return inf_;
+  }
+
+  [[nodiscard]] Field GetX() const {
+    return x_;
+  }
+
+  [[nodiscard]] Field GetY() const {
+    return y_;
+  }
+
+ private:
+  bool inf_;
+  Field x_;
+  Field y_;
+};
+
+// Point in Jacobian coordinates (X : Y : Z), which stands for the affine point
+// (X / Z^2, Y / Z^3). Z = 0 is the point at infinity. Group operations need
+// no inversions, so points stay in this form until they are printed.
+template<typename Curve>
+class BasicJacobianPoint {
+ public:
+  using Field = typename Curve::Field;
+
+  BasicJacobianPoint() : x_(0), y_(1), z_(0) {}
+
+  BasicJacobianPoint(Field x, Field y, Field z)
+          : x_(x),
+            y_(y),
+            z_(z) {}
+
+  explicit BasicJacobianPoint(const BasicCurvePoint<Curve>& point)
+          : x_(point.GetX()),
+            y_(point.GetY()),
+            z_(point.IsInf() ? 0 : 1) {}
+
+  [[nodiscard]] bool IsInf() const {
+    return z_.IsZero();
+  }
+
+  [[nodiscard]] Field GetX() const {
+    return x_;
+  }
+
+  [[nodiscard]] Field GetY() const {
+    return y_;
+  }
+
+  [[nodiscard]] Field GetZ() const {
+    return z_;
+  }
+
+ private:
+  Field x_;
+  Field y_;
+  Field z_;
+};
+
+// The decryptor works on P-256.
+using CurvePoint = BasicCurvePoint<P256>;
+using JacobianPoint = BasicJacobianPoint<P256>;
+
+// dbl-2007-bl.
+template<typename Curve>
+BasicJacobianPoint<Curve> Double(const BasicJacobianPoint<Curve>& point) {
+  using Field = typename Curve::Field;
+  if (point.IsInf()) {
+    return point;
+  }
+  Field xx = point.GetX().Square();
+  Field yy = point.GetY().Square();
+  Field yyyy = yy.Square();
+  Field zz = point.GetZ().Square();
+  Field s = (point.GetX() + yy).Square() - xx - yyyy;
+  s = s + s;
+  // m = 3 xx + a zz^2.
+  Field m;
+  if constexpr (Curve::kAForm == CoefficientA::kMinusThree) {
+    m = (point.GetX() - zz) * (point.GetX() + zz);
+    m = m + m + m;
+  } else {
+    m = xx + xx + xx + Curve::kA * zz.Square();
+  }
+  Field x = m.Square() - (s + s);
+  Field yyyy_8 = yyyy + yyyy;
+  yyyy_8 = yyyy_8 + yyyy_8;
+  yyyy_8 = yyyy_8 + yyyy_8;
+  Field y = m * (s - x) - yyyy_8;
+  Field z = (point.GetY() + point.GetZ()).Square() - yy - zz;
+  return {x, y, z};
+}
+
+// add-2007-bl.
+template<typename Curve>
+BasicJacobianPoint<Curve> operator*(const BasicJacobianPoint<Curve>& p1,
+                                    const BasicJacobianPoint<Curve>& p2) {
+  using Field = typename Curve::Field;
+  if (p1.IsInf()) {
+    return p2;
+  }
+  if (p2.IsInf()) {
+    return p1;
+  }
+  Field z1_z1 = p1.GetZ().Square();
+  Field z2_z2 = p2.GetZ().Square();
+  Field u1 = p1.GetX() * z2_z2;
+  Field u2 = p2.GetX() * z1_z1;
+  Field s1 = p1.GetY() * p2.GetZ() * z2_z2;
+  Field s2 = p2.GetY() * p1.GetZ() * z1_z1;
+  Field h = u2 - u1;
+  Field r = s2 - s1;
+  if (h.IsZero()) {
+    if (r.IsZero()) {
+      return Double(p1);
+    }
+    return {};
+  }
+  r = r + r;
+  Field i = (h + h).Square();
+  Field j = h * i;
+  Field v = u1 * i;
+  Field x = r.Square() - j - (v + v);
+  Field s1_j = s1 * j;
+  Field y = r * (v - x) - (s1_j + s1_j);
+  Field z = ((p1.GetZ() + p2.GetZ()).Square() - z1_z1 - z2_z2) * h;
+  return {x, y, z};
+}
+
+// madd-2007-bl, the second point is affine.
+template<typename Curve>
+BasicJacobianPoint<Curve> operator*(const BasicJacobianPoint<Curve>& p1,
+                                    const BasicCurvePoint<Curve>& p2) {
+  using Field = typename Curve::Field;
+  if (p1.IsInf()) {
+    return BasicJacobianPoint<Curve>(p2);
+  }
+  if (p2.IsInf()) {
+    return p1;
+  }
+  Field z1_z1 = p1.GetZ().Square();
+  Field u2 = p2.GetX() * z1_z1;
+  Field s2 = p2.GetY() * p1.GetZ() * z1_z1;
+  Field h = u2 - p1.GetX();
+  Field r = s2 - p1.GetY();
+  if (h.IsZero()) {
+    if (r.IsZero()) {
+      return Double(p1);
+    }
+    return {};
+  }
+  r = r + r;
+  Field hh = h.Square();
+  Field i = hh + hh;
+  i = i + i;
+  Field j = h * i;
+  Field v = p1.GetX() * i;
+  Field x = r.Square() - j - (v + v);
+  Field y1_j = p1.GetY() * j;
+  Field y = r * (v - x) - (y1_j + y1_j);
+  Field z = (p1.GetZ() + h).Square() - z1_z1 - hh;
+  return {x, y, z};
+}
+
+// Replaces every value by its inverse using Montgomery's trick: one inversion
+// and three multiplications per element. Zeros are left as they are.
+template<typename Field>
+void InvertBatch(std::vector<Field>& values) {
+  std::vector<Field> prefix(values.size() + 1);
+  prefix[0] = Field(1);
+  for (size_t i = 0; i < values.size(); ++i) {
+    prefix[i + 1] = values[i].IsZero() ? prefix[i] : prefix[i] * values[i];
+  }
+  Field inv = prefix.back().Inverse();
+  for (size_t i = values.size(); i > 0; --i) {
+    if (values[i - 1].IsZero()) {
+      continue;
+    }
+    Field value = values[i - 1];
+    values[i - 1] = inv * prefix[i - 1];
+    inv = inv * value;
+  }
+}
+
+template<typename Curve>
+BasicCurvePoint<Curve> ToAffine(const BasicJacobianPoint<Curve>& point,
+                                const typename Curve::Field& z_inv) {
+  if (point.IsInf()) {
+    return {};
+  }
+  typename Curve::Field z_inv_2 = z_inv.Square();
+  return {point.GetX() * z_inv_2, point.GetY() * z_inv_2 * z_inv};
+}
+
+template<typename Curve>
+BasicCurvePoint<Curve> ToAffine(const BasicJacobianPoint<Curve>& point) {
+  return ToAffine(point, point.GetZ().Inverse());
+}
+
+// Normalizes all points with a single field inversion.
+template<typename Curve>
+std::vector<BasicCurvePoint<Curve>>
+ToAffine(const std::vector<BasicJacobianPoint<Curve>>& points) {
+  std::vector<typename Curve::Field> z_inv;
+  z_inv.reserve(points.size());
+  for (const BasicJacobianPoint<Curve>& point : points) {
+    z_inv.push_back(point.GetZ());
+  }
+  InvertBatch(z_inv);
+  std::vector<BasicCurvePoint<Curve>> result;
+  result.reserve(points.size());
+  for (size_t i = 0; i < points.size(); ++i) {
+    result.push_back(ToAffine(points[i], z_inv[i]));
+  }
+  return result;
+}
+
+template<typename Curve>
+BasicCurvePoint<Curve> operator*(const BasicCurvePoint<Curve>& p1,
+                                 const BasicCurvePoint<Curve>& p2) {
+  return ToAffine(BasicJacobianPoint<Curve>(p1) * p2);
+}
+
+// Recovers the point from x and the parity of y. p = 3 (mod 4), so the square
+// root is a single exponentiation to (p + 1) / 4.
+template<typename Curve>
+BasicCurvePoint<Curve> Decompress(const typename Curve::Field& x, bool odd_y) {
+  using Field = typename Curve::Field;
+  static_assert(Field::kModulus[0] % 4 == 3);
+  Field y_2 = x.Square() * x + Curve::kA * x + Curve::kB;
+  Field y = y_2.Pow((Field::kModulus + 1) / 4);
+  if (y.Square() != y_2) {
+    throw std::runtime_error("Compressed point is not on the curve");
+  }
+  if (y.IsOdd() != odd_y) {
+    y = Field(0) - y;
+  }
+  return {x, y};
+}
+
+template<typename Curve>
+BasicJacobianPoint<Curve> Negate(const BasicJacobianPoint<Curve>& point) {
+  return {point.GetX(), typename Curve::Field(0) - point.GetY(),
+          point.GetZ()};
+}
+
+template<typename Curve>
+BasicCurvePoint<Curve> Negate(const BasicCurvePoint<Curve>& point) {
+  if (point.IsInf()) {
+    return point;
+  }
+  return {point.GetX(), typename Curve::Field(0) - point.GetY()};
+}
+
+const int kWnafWidth = 5;
+
+// Width-w non-adjacent form of k, least significant digit first. Non-zero
+// digits are odd, lie in (-2^(w-1), 2^(w-1)), and any w consecutive digits
+// contain at most one of them.
+template<unsigned N>
+std::vector<int> ToWnaf(const intx::uint<N>& k, int width) {
+  std::vector<int> digits;
+  digits.reserve(N + 1);
+  intx::uint<N + 64> rest = k;
+  const uint64_t mask = (uint64_t{1} << width) - 1;
+  while (rest != 0) {
+    int digit = 0;
+    if ((rest[0] & 1) != 0) {
+      digit = static_cast<int>(rest[0] & mask);
+      if (digit >= (1 << (width - 1))) {
+        digit -= 1 << width;
+        rest += static_cast<uint64_t>(-digit);
+      } else {
+        rest -= static_cast<uint64_t>(digit);
+      }
+    }
+    digits.push_back(digit);
+    rest >>= 1;
+  }
+  return digits;
+}
+
+// Computes k * point with a left-to-right wNAF ladder over the precomputed
+// odd multiples point, 3 point, ..., (2^(w-1) - 1) point.
+template<typename Curve>
+BasicJacobianPoint<Curve> Mul(const BasicCurvePoint<Curve>& point,
+                              const typename Curve::Scalar& k,
+                              int width = kWnafWidth) {
+  BasicJacobianPoint<Curve> result;
+  if (point.IsInf() || k == 0) {
+    return result;
+  }
+  std::vector<BasicJacobianPoint<Curve>> odd_multiples;
+  odd_multiples.reserve(size_t{1} << (width - 2));
+  odd_multiples.emplace_back(point);
+  BasicJacobianPoint<Curve> twice = Double(odd_multiples[0]);
+  for (size_t i = 1; i < (size_t{1} << (width - 2)); ++i) {
+    odd_multiples.push_back(odd_multiples.back() * twice);
+  }
+  std::vector<int> digits = ToWnaf(k, width);
+  for (size_t i = digits.size(); i > 0; --i) {
+    result = Double(result);
+    int digit = digits[i - 1];
+    if (digit > 0) {
+      result = result * odd_multiples[digit / 2];
+    } else if (digit < 0) {
+      result = result * Negate(odd_multiples[-digit / 2]);
+    }
+  }
+  return result;
+}
+
+}  // namespace math
+
+namespace encoding {
+
+char DecodeChar(int num) {
+  if (0 <= num && num <= 9) {
+    return static_cast<char>('0' + num);
+  }
+  if (10 <= num && num <= 35) {
+    return static_cast<char>('A' + num - 10);
+  }
+  if (36 <= num && num <= 61) {
+    return static_cast<char>('a' + num - 36);
+  }
+  if (num == 62) {
+    return '_';
+  }
+  if (num == 63) {
+    return '.';
+  }
+  return '\0';
+}
+
+std::string DecodeString(const math::Number& number) {
+  std::string s;
+  for (size_t i = 0; i < number.Size(); ++i) {
+    s.push_back(DecodeChar(number.GetDigit(i)));
+  }
+  return s;
+}
+
+}  // namespace encoding
+
+namespace io {
+
+constexpr size_t kBufferSize = 1 << 16;
+
+// Buffered input on top of fread with hand-rolled integer parsing. It can
+// also parse a memory region in place, e.g. a mapped file.
+class Reader {
+ public:
+  explicit Reader(FILE* file)
+          : file_(file), buffer_(kBufferSize), data_(buffer_.data()) {}
+
+  Reader(const char* data, size_t size)
+          : file_(nullptr), data_(data), size_(size) {}
+
+  Reader(const Reader&) = delete;
+  Reader& operator=(const Reader&) = delete;
+
+  // Returns the next character without extracting it, or EOF.
+  int Peek() {
+    if (pos_ == size_ && !Refill()) {
+      return EOF;
+    }
+    return static_cast<unsigned char>(data_[pos_]);
+  }
+
+  int Get() {
+    int c = Peek();
+    if (c != EOF) {
+      ++pos_;
+    }
+    return c;
+  }
+
+  void SkipSpaces() {
+    for (int c = Peek(); c == ' ' || c == '\n' || c == '\r' || c == '\t';
+         c = Peek()) {
+      ++pos_;
+    }
+  }
+
+  // Reads an unsigned decimal number, returns false if there is none.
+  bool Read(uint64_t& x) {
+    SkipSpaces();
+    int c = Peek();
+    if (c < '0' || c > '9') {
+      return false;
+    }
+    x = 0;
+    for (; c >= '0' && c <= '9'; c = Peek()) {
+      x = x * 10 + (c - '0');
+      ++pos_;
+    }
+    return true;
+  }
+
+  // Reads a whitespace-separated token, returns false at the end of input.
+  bool ReadToken(std::string& token) {
+    SkipSpaces();
+    token.clear();
+    for (int c = Peek(); c != EOF && c != ' ' && c != '\n' && c != '\r' &&
+                         c != '\t'; c = Peek()) {
+      token.push_back(static_cast<char>(c));
+      ++pos_;
+    }
+    return !token.empty();
+  }
+
+  // Reads the rest of the current line and extracts the line break. Returns
+  // false at the end of input.
+  bool ReadLine(std::string& line) {
+    line.clear();
+    if (Peek() == EOF) {
+      return false;
+    }
+    while (pos_ < size_ || Refill()) {
+      const char* begin = data_ + pos_;
+      const char* end = static_cast<const char*>(
+              std::memchr(begin, '\n', size_ - pos_));
+      if (end != nullptr) {
+        line.append(begin, end);
+        pos_ += end - begin + 1;
+        return true;
+      }
+      line.append(begin, size_ - pos_);
+      pos_ = size_;
+    }
+    return true;
+  }
+
+  // Reads up to n next characters of the current line, leaving the line
+  // break in place. Returns false when the line is exhausted.
+  bool ReadLineChunk(std::string& chunk, size_t n) {
+    chunk.clear();
+    while (chunk.size() < n && (pos_ < size_ || Refill())) {
+      const char* begin = data_ + pos_;
+      size_t available = std::min(size_ - pos_, n - chunk.size());
+      const char* end = static_cast<const char*>(
+              std::memchr(begin, '\n', available));
+      if (end != nullptr) {
+        chunk.append(begin, end);
+        pos_ += end - begin;
+        break;
+      }
+      chunk.append(begin, available);
+      pos_ += available;
+    }
+    return !chunk.empty();
+  }
+
+  // Reads n raw bytes, returns false if the input ends earlier.
+  bool ReadBytes(void* data, size_t n) {
+    auto* out = static_cast<char*>(data);
+    while (n > 0 && (pos_ < size_ || Refill())) {
+      size_t available = std::min(size_ - pos_, n);
+      std::memcpy(out, data_ + pos_, available);
+      pos_ += available;
+      out += available;
+      n -= available;
+    }
+    return n == 0;
+  }
+
+  // Reads a little-endian integer of the given width in bytes.
+  bool ReadLe(uint64_t& x, size_t bytes = sizeof(uint64_t)) {
+    uint8_t buffer[sizeof(uint64_t)];
+    if (!ReadBytes(buffer, bytes)) {
+      return false;
+    }
+    x = 0;
+    for (size_t i = bytes; i > 0; --i) {
+      x = (x << 8) | buffer[i - 1];
+    }
+    return true;
+  }
+
+ private:
+  bool Refill() {
+    if (file_ == nullptr) {
+      return false;
+    }
+    pos_ = 0;
+    size_ = std::fread(buffer_.data(), 1, buffer_.size(), file_);
+    return size_ > 0;
+  }
+
+  FILE* file_;
+  std::vector<char> buffer_;
+  const char* data_;
+  size_t pos_ = 0;
+  size_t size_ = 0;
+};
+
+// Read-only memory mapping of a whole file.
+class MappedFile {
+ public:
+  explicit MappedFile(const std::string& path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+      throw std::runtime_error("Cannot open " + path);
+    }
+    struct stat file_stat {};
+    if (fstat(fd, &file_stat) == 0) {
+      size_ = static_cast<size_t>(file_stat.st_size);
+    }
+    if (size_ > 0) {
+      void* data = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (data == MAP_FAILED) {
+        close(fd);
+        throw std::runtime_error("Cannot map " + path);
+      }
+      madvise(data, size_, MADV_SEQUENTIAL);
+      data_ = static_cast<const char*>(data);
+    }
+    close(fd);
+  }
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  ~MappedFile() {
+    if (data_ != nullptr) {
+      munmap(const_cast<char*>(data_), size_);
+    }
+  }
+
+  [[nodiscard]] const char* Data() const {
+    return data_;
+  }
+
+  [[nodiscard]] size_t Size() const {
+    return size_;
+  }
+
+ private:
+  const char* data_ = nullptr;
+  size_t size_ = 0;
+};
+
+// Buffered output on top of fwrite, flushed on destruction.
+class Writer {
+ public:
+  explicit Writer(FILE* file) : file_(file), buffer_(kBufferSize) {}
+
+  Writer(const Writer&) = delete;
+  Writer& operator=(const Writer&) = delete;
+
+  ~Writer() {
+    Flush();
+  }
+
+  void Write(char c) {
+    if (pos_ == buffer_.size()) {
+      Flush();
+    }
+    buffer_[pos_++] = c;
+  }
+
+  void Write(uint64_t x) {
+    char digits[20];
+    size_t n = 0;
+    do {
+      digits[n++] = static_cast<char>('0' + x % 10);
+      x /= 10;
+    } while (x > 0);
+    if (buffer_.size() - pos_ < n) {
+      Flush();
+    }
+    while (n > 0) {
+      buffer_[pos_++] = digits[--n];
+    }
+  }
+
+  void Write(const std::string& s) {
+    WriteBytes(s.data(), s.size());
+  }
+
+  void WriteBytes(const void* data, size_t n) {
+    const auto* in = static_cast<const char*>(data);
+    for (size_t written = 0; written < n;) {
+      if (pos_ == buffer_.size()) {
+        Flush();
+      }
+      size_t count = std::min(n - written, buffer_.size() - pos_);
+      std::memcpy(buffer_.data() + pos_, in + written, count);
+      pos_ += count;
+      written += count;
+    }
+  }
+
+  // Writes the lowest bytes of x in little-endian order.
+  void WriteLe(uint64_t x, size_t bytes = sizeof(uint64_t)) {
+    uint8_t buffer[sizeof(uint64_t)];
+    for (size_t i = 0; i < bytes; ++i) {
+      buffer[i] = static_cast<uint8_t>(x >> (8 * i));
+    }
+    WriteBytes(buffer, bytes);
+  }
+
+  void Flush() {
+    std::fwrite(buffer_.data(), 1, pos_, file_);
+    pos_ = 0;
+  }
+
+ private:
+  FILE* file_;
+  std::vector<char> buffer_;
+  size_t pos_ = 0;
+};
+
+// Binary ciphertext format, version 2. It has the layout of version 1
+// written by A and C except that the modulus takes 32 bytes. All integers are
+// little-endian:
+//   "EGCT", u32 version, u32 value width in bytes (32), u32 values per
+//   element (2 coordinates of a point, or 1 if compressed), 256-bit modulus,
+//   u64 number of pairs,
+// followed by the pairs of points. A compressed point is the SEC1 tag byte
+// (2 for even y, 3 for odd y) followed by x.
+constexpr char kBinaryMagic[4] = {'E', 'G', 'C', 'T'};
+constexpr uint64_t kBinaryVersion = 2;
+constexpr uint64_t kBinaryWidth = 32;
+
+bool ReadUint256(Reader& reader, intx::uint256& x) {
+  uint8_t bytes[kBinaryWidth];
+  if (!reader.ReadBytes(bytes, sizeof(bytes))) {
+    return false;
+  }
+  x = intx::le::load<intx::uint256>(bytes);
+  return true;
+}
+
+// Returns false if the input is not a supported binary ciphertext of P-256
+// points. degree is 2 for plain points and 1 for compressed ones.
+bool ReadBinaryHeader(Reader& reader, uint64_t& degree, uint64_t& count) {
+  char magic[sizeof(kBinaryMagic)];
+  uint64_t version;
+  uint64_t width;
+  intx::uint256 modulus;
+  return reader.ReadBytes(magic, sizeof(magic)) &&
+         std::memcmp(magic, kBinaryMagic, sizeof(magic)) == 0 &&
+         reader.ReadLe(version, 4) && version == kBinaryVersion &&
+         reader.ReadLe(width, 4) && width == kBinaryWidth &&
+         reader.ReadLe(degree, 4) && (degree == 1 || degree == 2) &&
+         ReadUint256(reader, modulus) &&
+         modulus == math::P256Field::kModulus && reader.ReadLe(count);
+}
+
+}  // namespace io
+
+namespace string_utils {
+
+const size_t kDecimalChunkDigits = 19;
+
+// Accumulates up to 19 digits in a word, then folds them in with a single
+// word-by-number multiply-add.
+intx::u5 StringTou5(const std::string& num_string) {
+  intx::u5 result = 0;
+  for (size_t begin = 0; begin < num_string.size();
+       begin += kDecimalChunkDigits) {
+    size_t end = std::min(begin + kDecimalChunkDigits, num_string.size());
+    uint64_t chunk = 0;
+    uint64_t scale = 1;
+    for (size_t i = begin; i < end; ++i) {
+      chunk = chunk * 10 + (num_string[i] - '0');
+      scale *= 10;
+    }
+    uint64_t carry = chunk;
+    for (size_t i = 0; i < intx::u5::num_words; ++i) {
+      math::uint128 current = static_cast<math::uint128>(result[i]) * scale +
+                              carry;
+      result[i] = static_cast<uint64_t>(current);
+      carry = static_cast<uint64_t>(current >> 64);
+    }
+  }
+  return result;
+}
+
+// Parses a decimal number of at most 154 digits, so that it fits in u5.
+bool ParseNumber(const std::string& num_string, intx::u5& x) {
+  if (num_string.empty() || num_string.size() > 154 ||
+      num_string.find_first_not_of("0123456789") != std::string::npos) {
+    return false;
+  }
+  x = StringTou5(num_string);
+  return true;
+}
+
+// Returns the point (x, y), or throws if the coordinates are not reduced or
+// the point is not on the curve.
+math::CurvePoint MakePoint(const intx::u5& x, const intx::u5& y) {
+  using Field = math::P256Field;
+  const intx::u5 modulus = Field::kModulus;
+  if (x >= modulus || y >= modulus) {
+    throw std::runtime_error("Point coordinate is not below the modulus");
+  }
+  Field field_x(x);
+  Field field_y(y);
+  if (field_y.Square() !=
+      field_x.Square() * field_x + math::P256::kA * field_x + math::P256::kB) {
+    throw std::runtime_error("Point is not on the curve");
+  }
+  return {field_x, field_y};
+}
+
+// Returns the point with the given x and parity of y, or throws if there is
+// none.
+math::CurvePoint MakeCompressedPoint(const intx::u5& x, bool odd_y) {
+  if (x >= intx::u5(math::P256Field::kModulus)) {
+    throw std::runtime_error("Point coordinate is not below the modulus");
+  }
+  return math::Decompress<math::P256>(math::P256Field(x), odd_y);
+}
+
+// Parses a point given either as "x y" or in the compressed form, and throws
+// if the line is not a valid point.
+math::CurvePoint ParsePoint(const std::string& line) {
+  const char* spaces = " \t\r";
+  std::vector<intx::u5> numbers;
+  for (size_t begin = line.find_first_not_of(spaces);
+       begin != std::string::npos;
+       begin = line.find_first_not_of(spaces, begin)) {
+    size_t end = line.find_first_of(spaces, begin);
+    if (numbers.size() == 2 ||
+        !ParseNumber(line.substr(begin, end - begin), numbers.emplace_back())) {
+      throw std::runtime_error("Invalid point: " + line);
+    }
+    begin = end;
+  }
+  if (numbers.empty()) {
+    throw std::runtime_error("Invalid point: " + line);
+  }
+  if (numbers.size() == 1) {
+    return MakeCompressedPoint(numbers[0] >> 1, (numbers[0][0] & 1) != 0);
+  }
+  return MakePoint(numbers[0], numbers[1]);
+}
+
+// Returns false at the end of the input and throws if the point is invalid.
+bool ReadPointBinary(io::Reader& reader, bool compressed,
+                     math::CurvePoint& point) {
+  intx::uint256 x;
+  if (!compressed) {
+    intx::uint256 y;
+    if (!io::ReadUint256(reader, x) || !io::ReadUint256(reader, y)) {
+      return false;
+    }
+    point = MakePoint(x, y);
+    return true;
+  }
+  uint64_t tag;
+  if (!reader.ReadLe(tag, 1) || !io::ReadUint256(reader, x)) {
+    return false;
+  }
+  if (tag != 2 && tag != 3) {
+    throw std::runtime_error("Invalid compressed point tag");
+  }
+  point = MakeCompressedPoint(x, tag == 3);
+  return true;
+}
+
+}  // namespace string_utils
+
+namespace crypto {
+
+// E appends this many salt bits to a message to make it the x-coordinate of a
+// point.
+const int kSaltBits = 8;
+
+// Inverse of E's EncodeMessage: strips the salt and splits x into base 64
+// digits.
+std::string DecodeMessage(const math::CurvePoint& point) {
+  intx::u5 message = point.GetX().ToU5() >> kSaltBits;
+  std::vector<uint64_t> digits;
+  while (message != 0) {
+    digits.push_back(static_cast<uint64_t>(message) & 63);
+    message >>= 6;
+  }
+  return encoding::DecodeString(math::Number(64, digits));
+}
+
+// EC-ElGamal decryption: message = c2 - private_key c1. The shared point
+// private_key c1 is computed once per distinct ephemeral point c1 of a batch.
+class Decryptor {
+ public:
+  Decryptor(const intx::uint256& private_key, size_t threads_count)
+          : private_key_(private_key),
+            threads_count_(threads_count) {}
+
+  std::vector<math::CurvePoint> DecryptBatch(
+          const std::vector<std::pair<math::CurvePoint, math::CurvePoint>>&
+          encrypted) const {
+    // Multiply the distinct ephemeral points by the private key on all
+    // threads, then normalize them together. Nothing is kept across batches:
+    // E picks a fresh ephemeral point for almost every pair.
+    std::vector<PointKey> keys;
+    keys.reserve(encrypted.size());
+    for (const auto& pair : encrypted) {
+      keys.push_back(Key(pair.first));
+    }
+    std::vector<PointKey> distinct_keys = keys;
+    std::sort(distinct_keys.begin(), distinct_keys.end());
+    distinct_keys.erase(
+            std::unique(distinct_keys.begin(), distinct_keys.end()),
+            distinct_keys.end());
+    std::vector<size_t> indices(encrypted.size());
+    std::vector<math::CurvePoint> ephemerals(distinct_keys.size());
+    for (size_t i = 0; i < encrypted.size(); ++i) {
+      indices[i] = std::lower_bound(distinct_keys.begin(),
+                                    distinct_keys.end(), keys[i]) -
+                   distinct_keys.begin();
+      ephemerals[indices[i]] = encrypted[i].first;
+    }
+    std::vector<math::JacobianPoint> shared(ephemerals.size());
+    std::atomic<size_t> next = 0;
+    auto worker = [&]() {
+      for (size_t i = next++; i < ephemerals.size(); i = next++) {
+        shared[i] = math::Mul(ephemerals[i], private_key_);
+      }
+    };
+    std::vector<std::thread> threads;
+    size_t threads_count = std::max<size_t>(
+            1, std::min(threads_count_, ephemerals.size()));
+    threads.reserve(threads_count - 1);
+    for (size_t i = 1; i < threads_count; ++i) {
+      threads.emplace_back(worker);
+    }
+    worker();
+    for (std::thread& thread : threads) {
+      thread.join();
+    }
+    std::vector<math::CurvePoint> shared_affine = math::ToAffine(shared);
+    for (math::CurvePoint& point : shared_affine) {
+      point = math::Negate(point);
+    }
+
+    std::vector<math::JacobianPoint> messages;
+    messages.reserve(encrypted.size());
+    for (size_t i = 0; i < encrypted.size(); ++i) {
+      messages.push_back(math::JacobianPoint(encrypted[i].second) *
+                         shared_affine[indices[i]]);
+    }
+    return math::ToAffine(messages);
+  }
+
+ private:
+  using PointKey = std::pair<intx::uint256, bool>;
+
+  static PointKey Key(const math::CurvePoint& point) {
+    if (point.IsInf()) {
+      return {math::P256Field::kModulus, false};
+    }
+    return {point.GetX().Value(), point.GetY().IsOdd()};
+  }
+
+  intx::uint256 private_key_;
+  size_t threads_count_;
+};
+
+}  // namespace crypto
+
+int main(int argc, char* argv[]) {
+#ifdef LOCAL
+  freopen("input.txt", "r", stdin);
+  freopen("output.txt", "w", stdout);
+#endif
+  // Parse options. With --input=FILE the input is mapped into memory instead
+  // of being read from stdin, --threads=N limits the worker threads.
+  std::string input_path;
+  size_t threads_count = std::max(1u, std::thread::hardware_concurrency());
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg.rfind("--input=", 0) == 0) {
+      input_path = arg.substr(8);
+    } else if (arg.rfind("--threads=", 0) == 0) {
+      threads_count = std::stoull(arg.substr(10));
+    }
+  }
+  std::optional<io::MappedFile> input_file;
+  if (!input_path.empty()) {
+    try {
+      input_file.emplace(input_path);
+    } catch (const std::runtime_error& error) {
+      std::fprintf(stderr, "%s\n", error.what());
+      return 1;
+    }
+  }
+
+  // Read input: the private key, then the output of E in any of its formats.
+  io::Reader reader = input_file
+                      ? io::Reader(input_file->Data(), input_file->Size())
+                      : io::Reader(stdin);
+  io::Writer writer(stdout);
+  std::string private_key_string;
+  intx::u5 private_key_number;
+  if (!reader.ReadToken(private_key_string) ||
+      !string_utils::ParseNumber(private_key_string, private_key_number)) {
+    std::fprintf(stderr, "Invalid private key\n");
+    return 1;
+  }
+  auto private_key = static_cast<intx::uint256>(
+          private_key_number % math::P256::kGroupSize);
+  crypto::Decryptor decryptor(private_key, threads_count);
+
+  reader.SkipSpaces();
+  uint64_t degree = 2;
+  uint64_t count = 0;
+  bool binary = reader.Peek() == io::kBinaryMagic[0];
+  if (binary && !io::ReadBinaryHeader(reader, degree, count)) {
+    std::fprintf(stderr, "Unsupported binary ciphertext\n");
+    return 1;
+  }
+  std::string line;
+  auto read_point = [&](math::CurvePoint& point) {
+    if (binary) {
+      return string_utils::ReadPointBinary(reader, degree == 1, point);
+    }
+    while (reader.ReadLine(line)) {
+      if (line.find_first_not_of(" \t\r") != std::string::npos) {
+        point = string_utils::ParsePoint(line);
+        return true;
+      }
+    }
+    return false;
+  };
+
+  // Decrypt and print.
+  constexpr size_t kBatchSize = 1 << 14;
+  std::vector<std::pair<math::CurvePoint, math::CurvePoint>> batch;
+  batch.reserve(kBatchSize);
+  auto flush = [&]() {
+    for (const math::CurvePoint& point : decryptor.DecryptBatch(batch)) {
+      writer.Write(crypto::DecodeMessage(point));
+      writer.Write('\n');
+    }
+    batch.clear();
+  };
+  math::CurvePoint first;
+  math::CurvePoint second;
+  try {
+    while ((!binary || count > 0) && read_point(first)) {
+      if (!read_point(second)) {
+        throw std::runtime_error("Ciphertext ends in the middle of a pair");
+      }
+      batch.emplace_back(first, second);
+      if (batch.size() == kBatchSize) {
+        flush();
+      }
+      if (binary) {
+        --count;
+      }
+    }
+  } catch (const std::runtime_error& error) {
+    std::fprintf(stderr, "%s\n", error.what());
+    return 1;
+  }
+  flush();
+  if (count > 0) {
+    std::fprintf(stderr, "Binary ciphertext is truncated\n");
+    return 1;
+  }
+  return 0;
+}